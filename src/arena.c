@@ -0,0 +1,259 @@
+/**
+ * @file arena.c
+ * @brief Alocador por regiões (arena), responsável pela memória de todos os valores criados durante uma avaliação.
+ *
+ * Os valores (strings, arrays, blocos e programas compilados) são alocados sequencialmente em blocos de memória de uma arena, pelo que
+ * nunca são libertados individualmente. No fim de uma avaliação, os valores que sobrevivem (stack final e variáveis) são copiados para a
+ * arena do contexto com `promote()` e a arena temporária é libertada de uma só vez com `arena_release()`.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "stack.h"
+
+#define ARENA_BLOCO 65536 ///< Tamanho de cada bloco de memória de uma arena.
+#define ARENA_GRANDE 16384 ///< Tamanho a partir do qual uma alocação recebe um bloco próprio.
+#define ARENA_ALINHAMENTO 16 ///< Alinhamento de todas as alocações.
+
+/**
+ * @brief Arena atual da thread, utilizada por `arena_alloc()` e `arena_realloc()`.
+ */
+_Thread_local ARENA *arena_atual = NULL;
+
+/**
+ * @brief Arredonda um tamanho para o múltiplo seguinte do alinhamento.
+ *
+ * @param n Tamanho.
+ * @return size_t Retorna o tamanho alinhado.
+ */
+size_t alinha(size_t n)
+{
+    return (n + ARENA_ALINHAMENTO - 1) & ~(size_t)(ARENA_ALINHAMENTO - 1);
+}
+
+/**
+ * @brief Cria uma nova arena, sem nenhum bloco alocado.
+ *
+ * @return ARENA* Retorna o endereço da nova arena.
+ */
+ARENA* new_arena()
+{
+    ARENA *a = malloc(sizeof(ARENA));
+    a->blocos = NULL;
+    a->grandes = NULL;
+    return a;
+}
+
+/**
+ * @brief Torna __a__ a arena atual da thread.
+ *
+ * @param a Arena.
+ * @return ARENA* Retorna a arena que era a atual, para que possa ser reposta.
+ */
+ARENA* arena_switch(ARENA *a)
+{
+    ARENA *anterior = arena_atual;
+    arena_atual = a;
+    return anterior;
+}
+
+/**
+ * @brief Aloca __n__ bytes na arena atual.
+ *
+ * As alocações pequenas são feitas sequencialmente no bloco atual (sendo criado um novo bloco quando este se esgota); as alocações
+ * grandes recebem um bloco próprio, para não desperdiçar o resto do bloco atual.
+ *
+ * @param n Número de bytes.
+ * @return void* Retorna o endereço da memória alocada.
+ */
+void* arena_alloc(size_t n)
+{
+    ARENA *a = arena_atual;
+    size_t cabecalho = alinha(sizeof(BLOCO_ARENA));
+    n = alinha(n ? n : 1);
+
+    if (n >= ARENA_GRANDE)
+    {
+        BLOCO_ARENA *g = malloc(cabecalho + n);
+        g->prox = a->grandes;
+        g->usado = n;
+        g->cap = n;
+        a->grandes = g;
+        return (char*)g + cabecalho;
+    }
+
+    BLOCO_ARENA *b = a->blocos;
+    if (b == NULL || b->usado + n > b->cap)
+    {
+        b = malloc(cabecalho + ARENA_BLOCO);
+        b->prox = a->blocos;
+        b->usado = 0;
+        b->cap = ARENA_BLOCO;
+        a->blocos = b;
+    }
+
+    void *r = (char*)b + cabecalho + b->usado;
+    b->usado += n;
+    return r;
+}
+
+/**
+ * @brief Aumenta uma alocação feita na arena atual de __antigo__ para __n__ bytes, preservando o seu conteúdo.
+ *
+ * Quando a alocação é a última feita no bloco atual (ou o último bloco grande), esta cresce no próprio lugar; caso contrário é feita
+ * uma nova alocação e o conteúdo é copiado, ficando a memória antiga por libertar até ao fim da avaliação.
+ *
+ * @param p Endereço da alocação (pode ser NULL).
+ * @param antigo Tamanho atual da alocação.
+ * @param n Novo tamanho.
+ * @return void* Retorna o novo endereço da alocação.
+ */
+void* arena_realloc(void *p, size_t antigo, size_t n)
+{
+    ARENA *a = arena_atual;
+    size_t cabecalho = alinha(sizeof(BLOCO_ARENA));
+
+    if (p == NULL)
+        return arena_alloc(n);
+    if (n <= antigo)
+        return p;
+
+    size_t tamanho = alinha(antigo ? antigo : 1);
+    BLOCO_ARENA *g = a->grandes;
+    if (tamanho >= ARENA_GRANDE && g != NULL && (char*)g + cabecalho == p)
+    {
+        n = alinha(n);
+        g = realloc(g, cabecalho + n);
+        g->usado = n;
+        g->cap = n;
+        a->grandes = g;
+        return (char*)g + cabecalho;
+    }
+
+    BLOCO_ARENA *b = a->blocos;
+    if (b != NULL && (char*)b + cabecalho + b->usado - tamanho == p && b->usado - tamanho + alinha(n) <= b->cap && alinha(n) < ARENA_GRANDE)
+    {
+        b->usado += alinha(n) - tamanho;
+        return p;
+    }
+
+    void *r = arena_alloc(n);
+    memcpy(r, p, antigo);
+    return r;
+}
+
+/**
+ * @brief Insere a lista de blocos __resto__ a seguir ao primeiro bloco da lista __lista__, que continua a ser o bloco atual.
+ *
+ * @param lista Endereço do início da lista de destino.
+ * @param resto Lista a inserir.
+ */
+void splice(BLOCO_ARENA **lista, BLOCO_ARENA *resto)
+{
+    BLOCO_ARENA **fim;
+
+    if (resto == NULL)
+        return;
+    if (*lista == NULL)
+    {
+        *lista = resto;
+        return;
+    }
+
+    for (fim = &resto; *fim; fim = &(*fim)->prox);
+    *fim = (*lista)->prox;
+    (*lista)->prox = resto;
+}
+
+/**
+ * @brief Transfere todos os blocos de __outra__ para __a__, que passa a ser responsável por os libertar. A arena __outra__ fica vazia.
+ *
+ * @param a Arena de destino.
+ * @param outra Arena de origem.
+ */
+void arena_adopt(ARENA *a, ARENA *outra)
+{
+    splice(&a->blocos, outra->blocos);
+    splice(&a->grandes, outra->grandes);
+
+    outra->blocos = NULL;
+    outra->grandes = NULL;
+}
+
+/**
+ * @brief Liberta, de uma só vez, toda a memória alocada numa arena, bem como a própria arena.
+ *
+ * @param a Arena.
+ */
+void arena_release(ARENA *a)
+{
+    BLOCO_ARENA *b, *prox;
+
+    for (b = a->blocos; b; b = prox)
+    {
+        prox = b->prox;
+        free(b);
+    }
+    for (b = a->grandes; b; b = prox)
+    {
+        prox = b->prox;
+        free(b);
+    }
+
+    free(a);
+}
+
+/**
+ * @brief Copia um valor (e tudo aquilo que este referencia) para a arena atual, para que sobreviva à libertação da arena onde foi criado.
+ *
+ * Os programas compilados dos blocos não são copiados: o bloco promovido volta a ser compilado na sua próxima execução.
+ *
+ * @param d Valor.
+ * @return DADOS Retorna a cópia do valor.
+ */
+DADOS promote(DADOS d)
+{
+    if (d.tipo == STRING)
+    {
+        STR *str = d.dados;
+        d.dados = new_str(str->str, str->len);
+    }
+    else if (d.tipo == ARRAY)
+    {
+        STACK *array = d.dados;
+        STACK *r = array->formato == ARVORE ? linearize(array) : array_slice(array, 1, array->sp);
+
+        unshare(r);
+
+        if (r->formato == GENERICO)
+            for (int i = 1; i <= r->sp; i++)
+                r->stack[i] = promote(r->stack[i]);
+
+        d.dados = r;
+    }
+    else if (d.tipo == BIGINT)
+    {
+        INTEIRO *a = d.dados;
+        INTEIRO *r = big_new(a->len);
+
+        memcpy(r->dig, a->dig, sizeof(uint32_t) * a->len);
+        r->neg = a->neg;
+        d.dados = r;
+    }
+    else if (d.tipo == BLOCK)
+    {
+        BLOCO *b = d.dados;
+        BLOCO *r = arena_alloc(sizeof(BLOCO));
+
+        char *texto = arena_alloc(b->len + 1);
+        memcpy(texto, b->texto, b->len);
+        texto[b->len] = '\0';
+        r->texto = texto;
+        r->len = b->len;
+        r->prog = NULL;
+
+        d.dados = r;
+    }
+
+    return d;
+}
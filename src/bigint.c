@@ -0,0 +1,1016 @@
+/**
+ * @file bigint.c
+ * @brief Inteiros de precisão arbitrária (BIGINT): aritmética, comparação e conversão de e para texto.
+ *
+ * Os inteiros são operados como LONG enquanto cabem num `long` (ver `long_add()` e as restantes operações de expMat.c); só quando
+ * uma operação excede um `long` é que o resultado é calculado aqui, com os operandos em base 2^32. Um resultado que volte a caber num
+ * `long` é devolvido como LONG (`big_value()`), pelo que as operações sobre valores pequenos não pagam nenhum custo adicional.
+ *
+ * A multiplicação usa o algoritmo de Karatsuba a partir de `KARATSUBA_LIMIAR` dígitos e a divisão o algoritmo D de Knuth. A conversão
+ * de e para base 10 divide o número ao meio por potências 10^(9 * 2^k), calculadas por quadrados sucessivos, pelo que também beneficia
+ * da multiplicação de Karatsuba.
+ *
+ * - __Nota:__ Os dígitos dos resultados são alocados na arena atual, tal como os restantes valores; a memória temporária da
+ * multiplicação, da divisão e da conversão para texto é libertada no fim de cada operação.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include "stack.h"
+
+#define BASE10 1000000000u ///< Maior potência de 10 que cabe num dígito: a conversão de e para texto trata nove algarismos de cada vez.
+
+// Operações sobre o módulo (dígitos em base 2^32)
+
+/**
+ * @brief Conta os dígitos de um módulo, ignorando os zeros à esquerda.
+ *
+ * @param a Dígitos.
+ * @param n Número de dígitos.
+ * @return long Retorna o número de dígitos significativos (0 caso o módulo seja zero).
+ */
+static long mag_len(const uint32_t *a, long n)
+{
+    while (n > 0 && a[n - 1] == 0)
+        n--;
+
+    return n;
+}
+
+/**
+ * @brief Compara dois módulos sem zeros à esquerda.
+ *
+ * @return int Retorna um valor negativo, zero ou positivo, caso __a__ seja menor, igual ou maior que __b__.
+ */
+static int mag_cmp(const uint32_t *a, long na, const uint32_t *b, long nb)
+{
+    if (na != nb)
+        return na < nb ? -1 : 1;
+
+    for (long i = na - 1; i >= 0; i--)
+        if (a[i] != b[i])
+            return a[i] < b[i] ? -1 : 1;
+
+    return 0;
+}
+
+/**
+ * @brief Soma __a__ a __r__ no próprio lugar (__na__ <= __nr__), propagando o transporte até ao fim de __r__.
+ *
+ * @return uint32_t Retorna o transporte que não coube em __r__.
+ */
+static uint32_t mag_add_in(uint32_t *r, long nr, const uint32_t *a, long na)
+{
+    uint64_t t = 0;
+    long i;
+
+    for (i = 0; i < na; i++)
+    {
+        t += (uint64_t) r[i] + a[i];
+        r[i] = (uint32_t) t;
+        t >>= 32;
+    }
+    for (; t != 0 && i < nr; i++)
+    {
+        t += r[i];
+        r[i] = (uint32_t) t;
+        t >>= 32;
+    }
+
+    return (uint32_t) t;
+}
+
+/**
+ * @brief Subtrai __a__ a __r__ no próprio lugar (__na__ <= __nr__), sendo __r__ maior ou igual a __a__.
+ */
+static void mag_sub_in(uint32_t *r, long nr, const uint32_t *a, long na)
+{
+    uint64_t emprestimo = 0;
+    long i;
+
+    for (i = 0; i < na; i++)
+    {
+        uint64_t t = (uint64_t) r[i] - a[i] - emprestimo;
+        r[i] = (uint32_t) t;
+        emprestimo = t >> 63;
+    }
+    for (; emprestimo != 0 && i < nr; i++)
+    {
+        emprestimo = r[i] == 0;
+        r[i]--;
+    }
+}
+
+/**
+ * @brief Multiplica dois módulos pelo método escolar, O(na * nb). __r__ tem espaço para __na__ + __nb__ dígitos.
+ */
+static void mag_mul_base(uint32_t *r, const uint32_t *a, long na, const uint32_t *b, long nb)
+{
+    memset(r, 0, sizeof(uint32_t) * (na + nb));
+
+    for (long i = 0; i < na; i++)
+    {
+        uint64_t t = 0;
+
+        if (a[i] == 0)
+            continue;
+        for (long j = 0; j < nb; j++)
+        {
+            t += (uint64_t) a[i] * b[j] + r[i + j];
+            r[i + j] = (uint32_t) t;
+            t >>= 32;
+        }
+        r[i + nb] = (uint32_t) t;
+    }
+}
+
+/**
+ * @brief Multiplica dois módulos. __r__ tem espaço para __na__ + __nb__ dígitos e não pode coincidir com __a__ nem com __b__.
+ *
+ * Abaixo de `KARATSUBA_LIMIAR` dígitos é utilizado o método escolar. Acima, com __a__ = a1 * B^m + a0 e __b__ = b1 * B^m + b0, são feitas
+ * apenas três multiplicações de metade do tamanho: a0 * b0, a1 * b1 e (a0 + a1) * (b0 + b1), de onde se obtém o termo central, O(n^1.58).
+ * Quando um dos operandos é muito mais curto, o mais longo é multiplicado por partes do tamanho do mais curto.
+ */
+static void mag_mul(uint32_t *r, const uint32_t *a, long na, const uint32_t *b, long nb)
+{
+    if (na < nb)
+    {
+        const uint32_t *t = a; a = b; b = t;
+        long n = na; na = nb; nb = n;
+    }
+
+    if (nb < KARATSUBA_LIMIAR)
+    {
+        mag_mul_base(r, a, na, b, nb);
+        return;
+    }
+
+    long m = (na + 1) / 2;
+
+    if (nb <= m)                    // Operandos desequilibrados: partes de __a__ com o tamanho de __b__
+    {
+        uint32_t *t = malloc(sizeof(uint32_t) * 2 * nb);
+
+        memset(r, 0, sizeof(uint32_t) * (na + nb));
+        for (long i = 0; i < na; i += nb)
+        {
+            long n = na - i < nb ? na - i : nb;
+
+            mag_mul(t, a + i, n, b, nb);
+            mag_add_in(r + i, na + nb - i, t, n + nb);
+        }
+
+        free(t);
+        return;
+    }
+
+    uint32_t *sa = malloc(sizeof(uint32_t) * (4 * m + 4));
+    uint32_t *sb = sa + m + 1;
+    uint32_t *z1 = sb + m + 1;
+
+    mag_mul(r, a, m, b, m);                                 // z0 = a0 * b0, em r[0 .. 2m)
+    mag_mul(r + 2 * m, a + m, na - m, b + m, nb - m);       // z2 = a1 * b1, em r[2m .. na + nb)
+
+    memcpy(sa, a, sizeof(uint32_t) * m);
+    sa[m] = mag_add_in(sa, m, a + m, na - m);
+    memcpy(sb, b, sizeof(uint32_t) * m);
+    sb[m] = mag_add_in(sb, m, b + m, nb - m);
+
+    mag_mul(z1, sa, m + 1, sb, m + 1);                      // z1 = (a0 + a1) * (b0 + b1) - z0 - z2
+    mag_sub_in(z1, 2 * m + 2, r, 2 * m);
+    mag_sub_in(z1, 2 * m + 2, r + 2 * m, na + nb - 2 * m);
+
+    mag_add_in(r + m, na + nb - m, z1, mag_len(z1, 2 * m + 2));
+
+    free(sa);
+}
+
+/**
+ * @brief Divide um módulo por um único dígito. __q__ (com __na__ dígitos) pode coincidir com __a__.
+ *
+ * @return uint32_t Retorna o resto.
+ */
+static uint32_t mag_div_small(uint32_t *q, const uint32_t *a, long na, uint32_t d)
+{
+    uint64_t r = 0;
+
+    for (long i = na - 1; i >= 0; i--)
+    {
+        uint64_t t = (r << 32) | a[i];
+        q[i] = (uint32_t) (t / d);
+        r = t % d;
+    }
+
+    return (uint32_t) r;
+}
+
+/**
+ * @brief Divide dois módulos sem zeros à esquerda (__na__ >= __nb__ >= 2), pelo algoritmo D de Knuth.
+ *
+ * O divisor é normalizado (deslocado até o seu dígito mais significativo ter o bit mais alto ativo), pelo que a estimativa de cada dígito
+ * do quociente, feita a partir dos dois primeiros dígitos do resto, excede o valor correto no máximo em 2 e é corrigida no próprio passo.
+ *
+ * @param q Quociente (__na__ - __nb__ + 1 dígitos).
+ * @param r Resto (__nb__ dígitos).
+ */
+static void mag_divmod(uint32_t *q, uint32_t *r, const uint32_t *a, long na, const uint32_t *b, long nb)
+{
+    uint32_t *un = malloc(sizeof(uint32_t) * (na + 1 + nb));
+    uint32_t *vn = un + na + 1;
+    int s = __builtin_clz(b[nb - 1]);
+
+    for (long i = nb - 1; i > 0; i--)
+        vn[i] = (uint32_t) (((uint64_t) b[i] << s) | ((uint64_t) b[i - 1] >> (32 - s)));
+    vn[0] = b[0] << s;
+
+    un[na] = (uint32_t) ((uint64_t) a[na - 1] >> (32 - s));
+    for (long i = na - 1; i > 0; i--)
+        un[i] = (uint32_t) (((uint64_t) a[i] << s) | ((uint64_t) a[i - 1] >> (32 - s)));
+    un[0] = a[0] << s;
+
+    for (long j = na - nb; j >= 0; j--)
+    {
+        uint64_t num = ((uint64_t) un[j + nb] << 32) | un[j + nb - 1];
+        uint64_t qhat = num / vn[nb - 1];
+        uint64_t rhat = num % vn[nb - 1];
+
+        while (qhat >> 32 || qhat * vn[nb - 2] > ((rhat << 32) | un[j + nb - 2]))
+        {
+            qhat--;
+            rhat += vn[nb - 1];
+            if (rhat >> 32)
+                break;
+        }
+
+        int64_t t, k = 0;
+        for (long i = 0; i < nb; i++)           // Subtrai qhat * divisor ao resto parcial
+        {
+            uint64_t p = qhat * vn[i];
+            t = un[i + j] - k - (int64_t) (p & 0xFFFFFFFF);
+            un[i + j] = (uint32_t) t;
+            k = (int64_t) (p >> 32) - (t >> 32);
+        }
+        t = un[j + nb] - k;
+        un[j + nb] = (uint32_t) t;
+
+        q[j] = (uint32_t) qhat;
+        if (t < 0)                              // A estimativa excedeu o dígito por 1: soma de novo o divisor
+        {
+            q[j]--;
+            un[j + nb] += mag_add_in(un + j, nb, vn, nb);
+        }
+    }
+
+    for (long i = 0; i < nb; i++)
+        r[i] = (uint32_t) ((((uint64_t) un[i + 1] << 32) | un[i]) >> s);
+
+    free(un);
+}
+
+/**
+ * @brief Calcula o inverso de um módulo sem zeros à esquerda, floor(B^(2 * __n__) / __b__), onde B = 2^32. __x__ tem espaço para __n__ + 2
+ * dígitos.
+ *
+ * Abaixo de 2 * `KARATSUBA_LIMIAR` dígitos o inverso é obtido por uma divisão. Acima, parte do inverso dos `h` dígitos mais significativos
+ * de __b__ (com cerca de metade da precisão) e faz um passo do método de Newton, x + x * (B^(2n) - b * x) / B^(2n), que duplica o número de
+ * dígitos corretos; o erro que resta, de algumas unidades, é corrigido somando ou subtraindo 1.
+ *
+ * @return long Retorna o número de dígitos do inverso.
+ */
+static long mag_recip(uint32_t *x, const uint32_t *b, long n)
+{
+    uint32_t um = 1;
+    uint32_t *pw = malloc(sizeof(uint32_t) * (2 * n + 1 + 2 * (2 * n + 2) + 3 * n + 4));
+    uint32_t *t = pw + 2 * n + 1;
+    uint32_t *e = t + 2 * n + 2;
+    uint32_t *c = e + 2 * n + 2;
+    long nx;
+
+    memset(pw, 0, sizeof(uint32_t) * 2 * n);                // pw = B^(2n)
+    pw[2 * n] = 1;
+
+    if (n < 2 * KARATSUBA_LIMIAR)
+    {
+        if (n == 1)
+            mag_div_small(x, pw, 3, b[0]);
+        else
+            mag_divmod(x, t, pw, 2 * n + 1, b, n);
+        free(pw);
+        return mag_len(x, n + 2);
+    }
+
+    long h = n / 2 + 2, l = n - h;
+
+    memset(x, 0, sizeof(uint32_t) * (n + 2));
+    nx = l + mag_recip(x + l, b + l, h);                    // Aproximação inicial: o inverso dos h dígitos mais significativos
+
+    long nt, ne;
+
+    mag_mul(t, b, n, x, nx);
+    nt = mag_len(t, n + nx);
+
+    if (mag_cmp(t, nt, pw, 2 * n + 1) <= 0)                // Passo de Newton, com e = |B^(2n) - b * x|
+    {
+        memcpy(e, pw, sizeof(uint32_t) * (2 * n + 1));
+        mag_sub_in(e, 2 * n + 1, t, nt);
+        ne = mag_len(e, 2 * n + 1);
+        if (ne > 0)
+        {
+            mag_mul(c, x, nx, e, ne);
+            if (nx + ne > 2 * n)
+                mag_add_in(x, n + 2, c + 2 * n, mag_len(c + 2 * n, nx + ne - 2 * n));
+        }
+    }
+    else
+    {
+        memcpy(e, t, sizeof(uint32_t) * nt);
+        mag_sub_in(e, nt, pw, 2 * n + 1);
+        ne = mag_len(e, nt);
+        mag_mul(c, x, nx, e, ne);
+        if (nx + ne > 2 * n)
+            mag_sub_in(x, n + 2, c + 2 * n, mag_len(c + 2 * n, nx + ne - 2 * n));
+        mag_sub_in(x, n + 2, &um, 1);
+    }
+
+    nx = mag_len(x, n + 2);
+    mag_mul(t, b, n, x, nx);
+    nt = mag_len(t, n + nx);
+    while (mag_cmp(t, nt, pw, 2 * n + 1) > 0)               // Correção: b * x <= B^(2n) < b * (x + 1)
+    {
+        mag_sub_in(x, n + 2, &um, 1);
+        mag_sub_in(t, nt, b, n);
+        nt = mag_len(t, nt);
+    }
+    memcpy(e, pw, sizeof(uint32_t) * (2 * n + 1));
+    mag_sub_in(e, 2 * n + 1, t, nt);
+    ne = mag_len(e, 2 * n + 1);
+    while (mag_cmp(e, ne, b, n) >= 0)
+    {
+        mag_add_in(x, n + 2, &um, 1);
+        mag_sub_in(e, ne, b, n);
+        ne = mag_len(e, ne);
+    }
+
+    free(pw);
+    return mag_len(x, n + 2);
+}
+
+/**
+ * @brief Divide um módulo __a__ < B^(2 * __nb__) (__nb__ <= __na__ <= 2 * __nb__) por __b__, dado o seu inverso (`mag_recip()`), pelo método
+ * de Barrett: o quociente é estimado com duas multiplicações, por defeito em no máximo 2, e corrigido subtraindo __b__ ao resto.
+ *
+ * @param q Quociente (__na__ - __nb__ + 1 dígitos).
+ * @param r Resto (__nb__ dígitos).
+ */
+static void mag_divmod_inv(uint32_t *q, uint32_t *r, const uint32_t *a, long na, const uint32_t *b, long nb, const uint32_t *inv, long ninv)
+{
+    uint32_t um = 1;
+    long na1 = na - nb + 1, nq = na1 + ninv - (nb + 1);
+    uint32_t *t = malloc(sizeof(uint32_t) * (na1 + ninv + 2 * na + 1));
+    uint32_t *p = t + na1 + ninv;
+    uint32_t *rr = p + na + 1;
+
+    mag_mul(t, a + nb - 1, na1, inv, ninv);                 // q = floor(floor(a / B^(nb - 1)) * inv / B^(nb + 1))
+    memset(q, 0, sizeof(uint32_t) * na1);
+    if (nq > 0)
+        memcpy(q, t + nb + 1, sizeof(uint32_t) * (nq < na1 ? nq : na1));
+
+    mag_mul(p, q, na1, b, nb);
+    memcpy(rr, a, sizeof(uint32_t) * na);
+    mag_sub_in(rr, na, p, mag_len(p, na + 1));
+
+    long nr = mag_len(rr, na);
+
+    while (mag_cmp(rr, nr, b, nb) >= 0)
+    {
+        mag_sub_in(rr, nr, b, nb);
+        nr = mag_len(rr, nr);
+        mag_add_in(q, na1, &um, 1);
+    }
+
+    memset(r, 0, sizeof(uint32_t) * nb);
+    memcpy(r, rr, sizeof(uint32_t) * nr);
+    free(t);
+}
+
+// Criação e normalização
+
+/**
+ * @brief Aloca um novo inteiro, com espaço para __len__ dígitos.
+ *
+ * @param len Número de dígitos.
+ * @return INTEIRO* Retorna o endereço do novo inteiro (positivo, com `len` dígitos por preencher).
+ */
+INTEIRO* big_new(long len)
+{
+    INTEIRO *r = arena_alloc(sizeof(INTEIRO) + sizeof(uint32_t) * len);
+
+    r->neg = 0;
+    r->len = len;
+
+    return r;
+}
+
+/**
+ * @brief Normaliza o resultado de uma operação: retira os zeros à esquerda e passa-o a LONG caso caiba num `long`.
+ *
+ * @param a Inteiro (que deixa de poder ser alterado).
+ * @return DADOS Retorna o elemento LONG ou BIGINT com o valor de __a__.
+ */
+DADOS big_value(INTEIRO *a)
+{
+    DADOS d;
+
+    a->len = mag_len(a->dig, a->len);
+
+    if (a->len <= 2)
+    {
+        uint64_t v = a->len == 0 ? 0 : a->len == 1 ? a->dig[0] : ((uint64_t) a->dig[1] << 32) | a->dig[0];
+
+        if (v <= (uint64_t) LONG_MAX || (a->neg && v == (uint64_t) LONG_MAX + 1))
+        {
+            d.tipo = LONG;
+            d.l = a->neg ? (long) (0 - v) : (long) v;
+            return d;
+        }
+    }
+
+    d.tipo = BIGINT;
+    d.dados = a;
+    return d;
+}
+
+/**
+ * @brief Indica se um elemento é um inteiro (LONG ou BIGINT).
+ *
+ * @param d Elemento.
+ * @return int Retorna 1 caso o elemento seja um inteiro, ou 0 caso contrário.
+ */
+int is_integer(DADOS d)
+{
+    return d.tipo == LONG || d.tipo == BIGINT;
+}
+
+/**
+ * @brief Obtém o sinal e o módulo de um inteiro. Um LONG é escrito em __tmp__, pelo que não é alocada memória.
+ *
+ * @param d Elemento LONG ou BIGINT.
+ * @param tmp Espaço para os dígitos de um LONG.
+ * @param n Endereço onde é guardado o número de dígitos.
+ * @param neg Endereço onde é guardado o sinal.
+ * @return const uint32_t* Retorna os dígitos do módulo.
+ */
+static const uint32_t* digits(DADOS d, uint32_t tmp[2], long *n, int *neg)
+{
+    if (d.tipo == BIGINT)
+    {
+        INTEIRO *a = d.dados;
+
+        *n = a->len;
+        *neg = a->neg;
+        return a->dig;
+    }
+
+    uint64_t v = d.l < 0 ? 0 - (uint64_t) d.l : (uint64_t) d.l;
+
+    tmp[0] = (uint32_t) v;
+    tmp[1] = (uint32_t) (v >> 32);
+    *n = mag_len(tmp, 2);
+    *neg = d.l < 0;
+    return tmp;
+}
+
+// Aritmética
+
+/**
+ * @brief Soma dois inteiros com sinal, dados pelos seus módulos.
+ *
+ * @return DADOS Retorna a soma.
+ */
+static DADOS add_signed(const uint32_t *a, long na, int nega, const uint32_t *b, long nb, int negb)
+{
+    INTEIRO *r;
+
+    if (na < nb || (nega != negb && mag_cmp(a, na, b, nb) < 0))
+    {
+        const uint32_t *t = a; a = b; b = t;
+        long n = na; na = nb; nb = n;
+        int s = nega; nega = negb; negb = s;
+    }
+
+    r = big_new(na + 1);
+    r->neg = nega;
+    memcpy(r->dig, a, sizeof(uint32_t) * na);
+
+    if (nega == negb)
+        r->dig[na] = mag_add_in(r->dig, na, b, nb);
+    else
+    {
+        r->dig[na] = 0;
+        mag_sub_in(r->dig, na, b, nb);
+    }
+
+    return big_value(r);
+}
+
+/**
+ * @brief Soma dois inteiros (LONG ou BIGINT) de qualquer tamanho.
+ *
+ * @param y Primeiro operando.
+ * @param x Segundo operando.
+ * @return DADOS Retorna a soma.
+ */
+DADOS big_add(DADOS y, DADOS x)
+{
+    uint32_t ty[2], tx[2];
+    long ny, nx;
+    int negy, negx;
+    const uint32_t *a = digits(y, ty, &ny, &negy);
+    const uint32_t *b = digits(x, tx, &nx, &negx);
+
+    return add_signed(a, ny, negy, b, nx, negx);
+}
+
+/**
+ * @brief Subtrai dois inteiros (LONG ou BIGINT) de qualquer tamanho.
+ *
+ * @param y Primeiro operando.
+ * @param x Segundo operando.
+ * @return DADOS Retorna a diferença __y__ - __x__.
+ */
+DADOS big_sub(DADOS y, DADOS x)
+{
+    uint32_t ty[2], tx[2];
+    long ny, nx;
+    int negy, negx;
+    const uint32_t *a = digits(y, ty, &ny, &negy);
+    const uint32_t *b = digits(x, tx, &nx, &negx);
+
+    return add_signed(a, ny, negy, b, nx, nx > 0 && !negx);
+}
+
+/**
+ * @brief Multiplica dois inteiros (LONG ou BIGINT) de qualquer tamanho.
+ *
+ * @param y Primeiro operando.
+ * @param x Segundo operando.
+ * @return DADOS Retorna o produto.
+ */
+DADOS big_mul(DADOS y, DADOS x)
+{
+    uint32_t ty[2], tx[2];
+    long ny, nx;
+    int negy, negx;
+    const uint32_t *a = digits(y, ty, &ny, &negy);
+    const uint32_t *b = digits(x, tx, &nx, &negx);
+    INTEIRO *r = big_new(ny + nx);
+
+    mag_mul(r->dig, a, ny, b, nx);
+    r->neg = negy != negx;
+
+    return big_value(r);
+}
+
+/**
+ * @brief Divide dois inteiros, truncando o quociente (como a divisão inteira de C): o resto tem o sinal do dividendo.
+ *
+ * @param y Dividendo.
+ * @param x Divisor.
+ * @param resto 1 para obter o resto, ou 0 para obter o quociente.
+ * @return DADOS Retorna o quociente ou o resto; caso o divisor seja 0, o resultado é o DOUBLE da divisão (`inf`) ou de `fmod()` (`nan`), como em `long_div()` e `long_mod()`.
+ */
+static DADOS big_divmod(DADOS y, DADOS x, int resto)
+{
+    uint32_t ty[2], tx[2];
+    long ny, nx;
+    int negy, negx;
+    const uint32_t *a = digits(y, ty, &ny, &negy);
+    const uint32_t *b = digits(x, tx, &nx, &negx);
+    INTEIRO *q, *r;
+
+    if (nx == 0)
+    {
+        DADOS d;
+
+        d.tipo = DOUBLE;
+        d.n = resto ? fmod(to_double(y), 0.0) : to_double(y) / 0.0;
+        return d;
+    }
+
+    q = big_new(ny >= nx ? ny - nx + 1 : 0);
+    r = big_new(nx);
+    q->neg = negy != negx;
+    r->neg = negy;
+
+    if (mag_cmp(a, ny, b, nx) < 0)
+    {
+        memcpy(r->dig, a, sizeof(uint32_t) * ny);
+        r->len = ny;
+        q->len = 0;
+    }
+    else if (nx == 1)
+    {
+        r->dig[0] = mag_div_small(q->dig, a, ny, b[0]);
+    }
+    else
+        mag_divmod(q->dig, r->dig, a, ny, b, nx);
+
+    return big_value(resto ? r : q);
+}
+
+/**
+ * @brief Divide dois inteiros (LONG ou BIGINT) de qualquer tamanho.
+ *
+ * @param y Dividendo.
+ * @param x Divisor.
+ * @return DADOS Retorna o quociente (truncado).
+ */
+DADOS big_div(DADOS y, DADOS x)
+{
+    return big_divmod(y, x, 0);
+}
+
+/**
+ * @brief Calcula o resto da divisão de dois inteiros (LONG ou BIGINT) de qualquer tamanho.
+ *
+ * @param y Dividendo.
+ * @param x Divisor.
+ * @return DADOS Retorna o resto, com o sinal do dividendo (como o operador `%` de C).
+ */
+DADOS big_mod(DADOS y, DADOS x)
+{
+    return big_divmod(y, x, 1);
+}
+
+/**
+ * @brief Compara dois inteiros (LONG ou BIGINT).
+ *
+ * @param a Elemento.
+ * @param b Elemento.
+ * @return int Retorna um valor negativo, zero ou positivo, caso __a__ seja menor, igual ou maior que __b__.
+ */
+int big_compare(DADOS a, DADOS b)
+{
+    uint32_t ta[2], tb[2];
+    long na, nb;
+    int nega, negb;
+    const uint32_t *x = digits(a, ta, &na, &nega);
+    const uint32_t *y = digits(b, tb, &nb, &negb);
+
+    if (nega != negb)
+        return nega ? -1 : 1;
+
+    return nega ? mag_cmp(y, nb, x, na) : mag_cmp(x, na, y, nb);
+}
+
+/**
+ * @brief Conta os bits do módulo de um inteiro (LONG ou BIGINT).
+ *
+ * @param d Elemento.
+ * @return long Retorna o número de bits do módulo (0 caso o inteiro seja 0).
+ */
+long big_bits(DADOS d)
+{
+    uint32_t t[2];
+    long n;
+    int neg;
+    const uint32_t *a = digits(d, t, &n, &neg);
+
+    return n == 0 ? 0 : 32 * n - __builtin_clz(a[n - 1]);
+}
+
+/**
+ * @brief Multiplica dois resíduos e reduz o produto módulo __m__.
+ *
+ * @return DADOS Retorna (__y__ * __x__) % __m__.
+ */
+static DADOS mul_mod(DADOS y, DADOS x, DADOS m)
+{
+    return big_mod(y.tipo == LONG && x.tipo == LONG ? long_mul(y.l, x.l) : big_mul(y, x), m);
+}
+
+/**
+ * @brief Calcula a potência modular __b__^__e__ % __m__ por exponenciação binária (quadrados sucessivos), em O(log e) multiplicações,
+ * sem nunca calcular a potência completa: cada produto é reduzido módulo __m__, pelo que os valores intermédios nunca excedem m^2.
+ *
+ * Quando |__m__| < 2^32, os produtos cabem num inteiro de 64 bits sem sinal e nenhum valor intermédio é alocado. O resultado é igual ao de
+ * `b e # m %`: tem o sinal de __b__^__e__ (como o operador `%` de C) e um expoente negativo conta como 0.
+ *
+ * @param b Base (LONG ou BIGINT).
+ * @param e Expoente (LONG ou BIGINT).
+ * @param m Módulo (LONG ou BIGINT, diferente de 0).
+ * @return DADOS Retorna a potência modular.
+ */
+DADOS big_mod_pow(DADOS b, DADOS e, DADOS m)
+{
+    uint32_t te[2], tm[2];
+    long ne, nm;
+    int nege, negm;
+    const uint32_t *de = digits(e, te, &ne, &nege);
+    const uint32_t *dm = digits(m, tm, &nm, &negm);
+    long bits = nege ? 0 : big_bits(e);
+    DADOS r, a, zero;
+
+    zero.tipo = r.tipo = LONG;
+    zero.l = 0;
+    r.l = 1;
+
+    int negb = big_compare(b, zero) < 0;
+
+    if (negm)
+        m = big_sub(zero, m);           // O sinal do módulo não altera o resto (tal como em C)
+
+    a = big_mod(b, m);                  // Base reduzida a [0, m)
+    if (a.tipo == BIGINT ? ((INTEIRO*)a.dados)->neg : a.l < 0)
+        a = big_add(a, m);
+
+    if (nm == 1)
+    {
+        uint64_t mm = dm[0], ra = 1 % mm, aa = (uint64_t) a.l;
+
+        for (long i = 0; i < bits; i++)
+        {
+            if (de[i / 32] >> (i % 32) & 1)
+                ra = ra * aa % mm;
+            if (i + 1 < bits)
+                aa = aa * aa % mm;
+        }
+
+        r.l = (long) ra;
+    }
+    else
+    {
+        for (long i = 0; i < bits; i++)
+        {
+            if (de[i / 32] >> (i % 32) & 1)
+                r = mul_mod(r, a, m);
+            if (i + 1 < bits)
+                a = mul_mod(a, a, m);
+        }
+    }
+
+    if (negb && bits > 0 && (de[0] & 1) && big_compare(r, zero) != 0)
+        r = big_sub(r, m);              // Base negativa e expoente ímpar: o resto tem o sinal negativo da potência
+
+    return r;
+}
+
+// Conversões
+
+/**
+ * @brief Converte um inteiro num `double` (arredondado a partir dos seus dígitos mais significativos).
+ *
+ * @param a Inteiro.
+ * @return double Retorna o valor aproximado (`inf` caso exceda o maior `double`).
+ */
+double big_to_double(INTEIRO *a)
+{
+    double r = 0;
+
+    for (long i = a->len - 1; i >= 0; i--)
+        r = r * 4294967296.0 + a->dig[i];
+
+    return a->neg ? -r : r;
+}
+
+/**
+ * @brief Converte um inteiro num `long`, guardando apenas os seus 64 bits menos significativos (em complemento para dois), como a
+ * conversão de um inteiro sem sinal de C. É o valor utilizado pelas operações sobre bits e pelos índices.
+ *
+ * @param a Inteiro.
+ * @return long Retorna os 64 bits menos significativos do inteiro.
+ */
+long big_to_long(INTEIRO *a)
+{
+    uint64_t v = a->dig[0] | (a->len > 1 ? (uint64_t) a->dig[1] << 32 : 0);
+
+    return (long) (a->neg ? 0 - v : v);
+}
+
+/**
+ * @brief Calcula a potência 10^(9 * 2^__k__) (o quadrado da anterior, ou 10^9 quando __k__ é 0), para a conversão de e para texto.
+ *
+ * @param pot Potências já calculadas (dígitos alocados com `malloc()`).
+ * @param plen Número de dígitos de cada potência.
+ * @param k Índice da nova potência.
+ */
+static void pot10(uint32_t **pot, long *plen, int k)
+{
+    if (k == 0)
+    {
+        pot[0] = malloc(sizeof(uint32_t));
+        pot[0][0] = BASE10;
+        plen[0] = 1;
+        return;
+    }
+
+    pot[k] = malloc(sizeof(uint32_t) * 2 * plen[k - 1]);
+    mag_mul(pot[k], pot[k - 1], plen[k - 1], pot[k - 1], plen[k - 1]);
+    plen[k] = mag_len(pot[k], 2 * plen[k - 1]);
+}
+
+/**
+ * @brief Escreve um módulo menor do que 10^(9 * 2^(__k__ + 1)) em base 10, com exatamente 9 * 2^(__k__ + 1) algarismos (com zeros à
+ * esquerda). Um módulo grande é dividido por 10^(9 * 2^k), e o quociente e o resto são escritos da mesma forma com metade dos
+ * algarismos; abaixo de `KARATSUBA_LIMIAR` dígitos é dividido repetidamente por 10^9.
+ *
+ * @param p Algarismos.
+ * @param a Módulo (que é alterado).
+ * @param na Número de dígitos do módulo.
+ */
+static void put_digits(char *p, uint32_t *a, long na, uint32_t **pot, long *plen, uint32_t **inv, long *ninv, int k)
+{
+    long metade = 9L << k;
+
+    na = mag_len(a, na);
+    if (k == 0 || na < KARATSUBA_LIMIAR)
+    {
+        for (char *q = p + 2 * metade; q > p; q -= 9)          // Do grupo menos significativo para o mais significativo
+        {
+            uint32_t g = na > 0 ? mag_div_small(a, a, na, BASE10) : 0;
+
+            na = mag_len(a, na);
+            for (int j = 1; j <= 9; j++, g /= 10)
+                q[-j] = '0' + g % 10;
+        }
+        return;
+    }
+
+    if (na < plen[k])
+    {
+        memset(p, '0', metade);
+        put_digits(p + metade, a, na, pot, plen, inv, ninv, k - 1);
+        return;
+    }
+
+    uint32_t *q = malloc(sizeof(uint32_t) * (na + 1));
+    uint32_t *r = q + na - plen[k] + 1;
+
+    mag_divmod_inv(q, r, a, na, pot[k], plen[k], inv[k], ninv[k]);
+    put_digits(p, q, na - plen[k] + 1, pot, plen, inv, ninv, k - 1);
+    put_digits(p + metade, r, plen[k], pot, plen, inv, ninv, k - 1);
+    free(q);
+}
+
+/**
+ * @brief Converte um inteiro numa nova string em base 10, com o mesmo formato que `printf("%ld")`.
+ *
+ * O módulo é dividido por 10^(9 * 2^k), a maior potência da forma 10^(9 * 2^i) necessária, e as duas metades são convertidas da mesma
+ * forma (`put_digits()`). Como a divisão usa a multiplicação de Karatsuba, a conversão deixa de custar O(n^2).
+ *
+ * @param a Inteiro.
+ * @return STR* Retorna a nova string.
+ */
+STR* big_to_str(INTEIRO *a)
+{
+    uint32_t *pot[64], *inv[64];
+    long plen[64], ninv[64];
+    int k = 0;
+
+    pot10(pot, plen, 0);
+    while (2 * (plen[k] - 1) < a->len)                          // Até o quadrado de pot[k] exceder o módulo
+    {
+        pot10(pot, plen, ++k);
+        inv[k] = malloc(sizeof(uint32_t) * (plen[k] + 2));
+        ninv[k] = mag_recip(inv[k], pot[k], plen[k]);
+    }
+
+    long n = 18L << k;
+    uint32_t *m = malloc(sizeof(uint32_t) * a->len + n);
+    char *t = (char *) (m + a->len), *ini = t;
+
+    memcpy(m, a->dig, sizeof(uint32_t) * a->len);
+    put_digits(t, m, a->len, pot, plen, inv, ninv, k);
+    while (*ini == '0')
+        ini++;
+
+    STR *r = new_str_cap(a->neg + (t + n - ini));
+
+    if (a->neg)
+        str_append(r, "-", 1);
+    str_append(r, ini, t + n - ini);
+
+    free(m);
+    for (int i = 0; i <= k; i++)
+    {
+        free(pot[i]);
+        if (i > 0)
+            free(inv[i]);
+    }
+
+    return r;
+}
+
+/**
+ * @brief Lê __m__ algarismos para um módulo, com espaço para __m__ / 9 + 2 dígitos. Os algarismos são separados nos últimos 9 * 2^k
+ * (a maior potência de 2 que deixa algarismos na primeira parte) e nos restantes, e o módulo é `alto` * 10^(9 * 2^k) + `baixo`; abaixo de
+ * 9 * `KARATSUBA_LIMIAR` algarismos são acumulados nove de cada vez.
+ *
+ * @return long Retorna o número de dígitos do módulo.
+ */
+static long get_digits(uint32_t *r, const char *s, long m, uint32_t **pot, long *plen, int k)
+{
+    if (m <= 9 * KARATSUBA_LIMIAR)
+    {
+        long n = 0;
+
+        for (const char *fim = s + m; s < fim; )
+        {
+            long g = (fim - s) % 9 ? (fim - s) % 9 : 9;     // O primeiro grupo fica com os algarismos que sobram
+            uint32_t v = 0, mult = 1;
+            uint64_t t;
+
+            for (long i = 0; i < g; i++, s++)
+            {
+                v = v * 10 + (*s - '0');
+                mult *= 10;
+            }
+
+            t = v;
+            for (long i = 0; i < n; i++)
+            {
+                t += (uint64_t) r[i] * mult;
+                r[i] = (uint32_t) t;
+                t >>= 32;
+            }
+            if (t != 0)
+                r[n++] = (uint32_t) t;
+        }
+
+        return n;
+    }
+
+    while (9L << k >= m)
+        k--;
+
+    long baixo = 9L << k;
+    uint32_t *h = malloc(sizeof(uint32_t) * ((m - baixo) / 9 + 2 + baixo / 9 + 2));
+    uint32_t *l = h + (m - baixo) / 9 + 2;
+    long nh = get_digits(h, s, m - baixo, pot, plen, k);
+    long nl = get_digits(l, s + m - baixo, baixo, pot, plen, k);
+    long n = nh > 0 ? nh + plen[k] : nl;
+
+    if (nh > 0)
+        mag_mul(r, h, nh, pot[k], plen[k]);
+    else
+        memset(r, 0, sizeof(uint32_t) * n);
+    mag_add_in(r, n, l, nl);
+    free(h);
+
+    return mag_len(r, n);
+}
+
+/**
+ * @brief Lê um inteiro em base 10 de qualquer tamanho do início de um texto, tal como `parse_long()`, mas sem limitar o valor ao intervalo
+ * de um `long`.
+ *
+ * Os textos curtos (que cabem sempre num `long`) são lidos diretamente por `parse_long()`; nos restantes, os algarismos são divididos ao
+ * meio e as duas partes combinadas com uma multiplicação por uma potência de 10 (`get_digits()`), em tempo subquadrático.
+ *
+ * @param s Texto.
+ * @param len Comprimento do texto.
+ * @return DADOS Retorna o inteiro lido, LONG ou BIGINT (0 caso o texto não comece por um inteiro).
+ */
+DADOS big_parse(const char* s, long len)
+{
+    const char *p = s, *fim = s + len, *ini;
+    DADOS d;
+    int neg = 0;
+
+    d.tipo = LONG;
+    if (len <= 18)
+    {
+        d.l = parse_long(s, len);
+        return d;
+    }
+
+    while (p < fim && (*p == ' ' || (*p >= '\t' && *p <= '\r')))
+        p++;
+    if (p < fim && (*p == '-' || *p == '+'))
+        neg = *p++ == '-';
+    for (ini = p; p < fim && *p >= '0' && *p <= '9'; p++);
+
+    if (p - ini <= 18)
+    {
+        d.l = parse_long(s, len);
+        return d;
+    }
+
+    uint32_t *pot[64];
+    long plen[64];
+    int k = -1;
+
+    while (9L << (k + 1) < (p - ini) && (p - ini) > 9 * KARATSUBA_LIMIAR)
+        pot10(pot, plen, ++k);
+
+    INTEIRO *r = big_new((p - ini) / 9 + 2);
+
+    r->len = get_digits(r->dig, ini, p - ini, pot, plen, k);
+    r->neg = neg;
+    for (int i = 0; i <= k; i++)
+        free(pot[i]);
+
+    return big_value(r);
+}
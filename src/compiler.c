@@ -0,0 +1,489 @@
+/**
+ * @file compiler.c
+ * @brief Compilação do input num array de instruções e máquina virtual que as executa.
+ *
+ * O programa (ou o conteúdo de um bloco) é dividido em tokens uma única vez. Cada token é classificado e convertido numa instrução,
+ * sendo os literais (números, strings e blocos) interpretados durante a compilação. A execução é feita por um único ciclo, `run_program()`,
+ * que percorre as instruções e despacha cada uma através de um `switch` denso (compilado numa tabela de saltos).
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "stack.h"
+
+/**
+ * @brief Acrescenta uma instrução ao programa, aumentando a capacidade do array de instruções quando necessário.
+ *
+ * @param p Programa.
+ * @param op Código da operação.
+ * @return INSTRUCAO* Retorna o endereço da instrução acrescentada.
+ */
+INSTRUCAO* emit(PROGRAMA* p, OPCODE op)
+{
+    if (p->n == p->cap)
+    {
+        p->cap = p->cap ? p->cap * 2 : 8;
+        p->instr = arena_realloc(p->instr, sizeof(INSTRUCAO) * p->n, sizeof(INSTRUCAO) * p->cap);
+    }
+
+    INSTRUCAO* i = &p->instr[p->n++];
+    i->op = op;
+    i->arg = 0;
+    i->lit.tipo = LONG;
+    i->lit.dados = NULL;
+    i->sub = NULL;
+
+    return i;
+}
+
+/**
+ * @brief Cria um programa vazio, alocado na arena atual.
+ *
+ * @return PROGRAMA* Retorna o endereço do novo programa.
+ */
+PROGRAMA* new_program()
+{
+    PROGRAMA* p = arena_alloc(sizeof(PROGRAMA));
+    p->instr = NULL;
+    p->n = 0;
+    p->cap = 0;
+    return p;
+}
+
+/**
+ * @brief Classifica os operadores compostos por um único caracter.
+ *
+ * @param c Caracter.
+ * @return OPCODE Retorna o código da operação, ou `OP_NOP` caso o caracter não seja um operador.
+ */
+OPCODE op_char(char c)
+{
+    switch (c)
+    {
+        // Expressões matemáticas
+
+        case '+': return OP_ADD;        // Também opera com arrays/strings
+        case '*': return OP_MUL;        // Também opera com arrays/strings e blocos
+        case '/': return OP_DIV;
+        case '(': return OP_DECR;       // Também opera com arrays/strings
+        case ')': return OP_INCR;       // Também opera com arrays/strings
+        case '%': return OP_MOD;        // Também opera com blocos
+        case '#': return OP_EXPO;       // Também opera com arrays/strings
+        case '&': return OP_BAND;
+        case '|': return OP_BOR;
+        case '^': return OP_BXOR;
+        case '~': return OP_BNOT;       // Também opera com arrays/blocos
+
+        // Input/Output
+
+        case 'l': return OP_LINE;
+        case 't': return OP_LINES;
+
+        // Blocks
+
+        case 'w': return OP_WHILE;
+
+        // Conversões
+
+        case 'i': return OP_INT;
+        case 'f': return OP_DOUBLE;
+        case 'c': return OP_CHAR;
+        case 's': return OP_STRING;
+
+        // Stack
+
+        case '_': return OP_DUP;
+        case ';': return OP_POP;
+        case '\\': return OP_SWAP;
+        case '@': return OP_SPIN;
+        case '$': return OP_NCOPY;
+
+        // Lógica
+
+        case '=': return OP_EQUAL;      // Também opera com arrays/strings
+        case '<': return OP_SMALLER;    // Também opera com arrays/strings
+        case '>': return OP_BIGGER;     // Também opera com arrays/strings
+        case '!': return OP_LNOT;
+        case '?': return OP_IF;
+
+        // Arrays e Strings
+
+        case ',': return OP_RANGE;      // Também opera com blocos
+
+        default: return OP_NOP;
+    }
+}
+
+/**
+ * @brief Classifica os operadores precedidos de 'e': os operadores lógicos (`e&`, `e|`, `e<` e `e>`) e a potência modular (`e#`).
+ *
+ * @param c Caracter que sucede o 'e'.
+ * @return OPCODE Retorna o código da operação, ou `OP_NOP` caso não se trate de um operador.
+ */
+OPCODE op_e(char c)
+{
+    switch (c)
+    {
+        case '&': return OP_AND;
+        case '|': return OP_OR;
+        case '<': return OP_MIN;
+        case '>': return OP_MAX;
+        case '#': return OP_MODPOW;
+        default: return OP_NOP;
+    }
+}
+
+/**
+ * @brief Analisador léxico: lê o próximo token do programa, a partir da posição atual do índice, sem copiar o texto.
+ * 
+ * Os tokens são separados por espaços e o programa termina no fim do texto, num '\0' ou numa mudança de linha. Uma string vai até às
+ * aspas seguintes (podendo conter espaços e parênteses retos ou chavetas) e os caracteres '[', ']', '{' e '}' são tokens próprios; as
+ * palavras terminam num espaço ou num ']' ou '}' (por exemplo, em `[1 2]`). O início e o fim de cada token são obtidos do índice
+ * estrutural (`index_next()`), pelo que apenas o primeiro caracter de cada token é examinado.
+ * 
+ * @param ind Índice estrutural do programa, cuja posição avança para depois do token.
+ * @return TOKEN Retorna o token lido (do tipo `TOKEN_FIM`, a apontar para o fim, caso não reste nenhum).
+ */
+TOKEN next_token(INDICE* ind)
+{
+    long pos = index_next(ind, MAPA_TOKENS, ind->pos);
+    const char* p = ind->texto + pos;
+    TOKEN t;
+
+    t.ini = p;
+    t.len = 0;
+
+    if (pos == ind->len || *p == '\0' || *p == '\n')
+        t.tipo = TOKEN_FIM;
+    else if (*p == '"')
+    {
+        long fim = index_next(ind, MAPA_STRINGS, pos + 1);
+
+        t.tipo = TOKEN_STRING;
+        t.ini = p + 1;
+        t.len = fim - pos - 1;
+        pos = fim < ind->len && ind->texto[fim] == '"' ? fim + 1 : fim;
+    }
+    else if (*p == '[' || *p == ']' || *p == '{' || *p == '}')
+    {
+        t.tipo = *p == '[' ? TOKEN_ABRE_ARRAY : *p == ']' ? TOKEN_FECHA_ARRAY : *p == '{' ? TOKEN_ABRE_BLOCO : TOKEN_FECHA_BLOCO;
+        t.len = 1;
+        pos++;
+    }
+    else
+    {
+        long fim = index_next(ind, MAPA_PALAVRAS, pos);
+
+        t.tipo = TOKEN_PALAVRA;
+        t.len = fim - pos;
+        pos = fim;
+    }
+
+    ind->pos = pos;
+    return t;
+}
+
+/**
+ * @brief Converte um token numa instrução, acrescentando-a ao programa.
+ *
+ * Os tokens que não são operadores nem variáveis são operandos, que são interpretados neste momento e guardados como literais.
+ *
+ * @param p Programa.
+ * @param t Token a compilar (uma palavra ou uma string).
+ */
+void compile_token(PROGRAMA* p, TOKEN t)
+{
+    if (t.tipo == TOKEN_STRING)
+    {
+        emit(p, OP_STR)->lit = create_string(t.ini, t.len);
+        return;
+    }
+    if (t.tipo != TOKEN_PALAVRA)
+        return;
+
+    char c = t.ini[0], c1 = t.len > 1 ? t.ini[1] : '\0';
+    OPCODE op = op_char(c);
+
+    if (op != OP_NOP)
+    {
+        emit(p, op);
+        return;
+    }
+
+    switch (c)
+    {
+        case 'e': { op = op_e(c1); if (op != OP_NOP) emit(p, op); return; }
+        case 'N':
+        case 'S':
+        {
+            if (c1 == '/')
+                emit(p, c == 'N' ? OP_DIV_NEWLINE : OP_DIV_WS);
+            else if (t.len == 1)
+                emit(p, OP_GET_VAR)->arg = c - 'A';
+            return;
+        }
+        case ':': { if (c1 >= 'A' && c1 <= 'Z') emit(p, OP_SET_VAR)->arg = c1 - 'A'; return; }
+    }
+
+    if (c == '-' && t.len == 1)
+        emit(p, OP_SUB);
+    else if (c >= 'A' && c <= 'Z')
+        emit(p, OP_GET_VAR)->arg = c - 'A';
+    else
+        emit(p, OP_LIT)->lit = val(t.ini, t.len);
+}
+
+/**
+ * @brief Compila os tokens de um programa até ao fim do texto ou até ao token __fecho__, que termina o array ou bloco literal que está a ser
+ * compilado.
+ *
+ * O conteúdo dos arrays e dos blocos literais é compilado recursivamente a partir da mesma posição, pelo que cada caracter do programa é
+ * lido uma única vez. Os tokens ']' e '}' que não fecham nenhum array ou bloco são ignorados.
+ *
+ * @param p Programa.
+ * @param ind Índice estrutural do programa, cuja posição avança para depois do último token compilado.
+ * @param fecho Tipo do token que termina a compilação (`TOKEN_FIM` no programa principal).
+ * @return TOKEN Retorna o token que terminou a compilação (__fecho__, ou `TOKEN_FIM` caso este não exista).
+ */
+TOKEN compile_tokens(PROGRAMA* p, INDICE* ind, TIPO_TOKEN fecho)
+{
+    TOKEN t;
+
+    while ((t = next_token(ind)).tipo != TOKEN_FIM && t.tipo != fecho)
+    {
+        if (t.tipo == TOKEN_ABRE_ARRAY)
+        {
+            PROGRAMA* sub = new_program();
+
+            compile_tokens(sub, ind, TOKEN_FECHA_ARRAY);
+            emit(p, OP_ARRAY)->sub = sub;
+        }
+        else if (t.tipo == TOKEN_ABRE_BLOCO)
+        {
+            PROGRAMA* sub = new_program();
+            const char* texto = ind->texto + ind->pos;
+            TOKEN f = compile_tokens(sub, ind, TOKEN_FECHA_BLOCO);
+
+            emit(p, OP_BLOCK)->lit = create_block(texto, f.ini - texto, sub);
+        }
+        else
+            compile_token(p, t);
+    }
+
+    return t;
+}
+
+/**
+ * @brief Compila um programa (programa principal ou texto de um bloco) num array de instruções.
+ *
+ * O texto é dividido em tokens uma única vez, com a função `next_token()` sobre o índice estrutural do texto, terminando no fim do texto
+ * ou numa mudança de linha.
+ *
+ * @param line Texto do programa.
+ * @param len Comprimento do texto.
+ * @return PROGRAMA* Retorna o programa compilado.
+ */
+PROGRAMA* compile(const char* line, int len)
+{
+    PROGRAMA* p = new_program();
+    INDICE ind;
+
+    index_init(&ind, line, len);
+    compile_tokens(p, &ind, TOKEN_FIM);
+    return p;
+}
+
+/**
+ * @brief Executa um programa compilado sobre uma stack.
+ *
+ * Cada instrução é despachada diretamente para a função que implementa o operador correspondente. As strings literais não são copiadas:
+ * são partilhadas com o programa, que mantém sempre uma referência, pelo que só são copiadas quando um operador as tenta alterar.
+ *
+ * @param s Stack.
+ * @param p Programa compilado.
+ * @param var Array que armazena as variáveis.
+ */
+void run_program(STACK* s, PROGRAMA* p, DADOS *var)
+{
+    INSTRUCAO* i = p->instr;
+    INSTRUCAO* fim = i + p->n;
+
+    for (; i < fim; i++)
+    {
+        switch (i->op)
+        {
+            case OP_NOP: break;
+            case OP_LIT: { push(s, i->lit); break; }
+            case OP_STR: { push(s, i->lit); break; }
+            case OP_ARRAY: { create_array(s, i->sub, var); break; }
+            case OP_BLOCK: { push(s, i->lit); break; }
+
+            case OP_ADD: { s_add(s); break; }
+            case OP_SUB: { subtract(s); break; }
+            case OP_MUL: { multiply(s, var); break; }
+            case OP_DIV: { divide(s); break; }
+            case OP_DECR: { decr(s); break; }
+            case OP_INCR: { incr(s); break; }
+            case OP_MOD: { mod(s, var); break; }
+            case OP_EXPO: { expo(s); break; }
+            case OP_MODPOW: { mod_pow(s); break; }
+            case OP_BAND: { bit_and(s); break; }
+            case OP_BOR: { bit_or(s); break; }
+            case OP_BXOR: { bit_xor(s); break; }
+            case OP_BNOT: { bit_not(s, var); break; }
+
+            case OP_LINE: { new_line(s); break; }
+            case OP_LINES: { all_lines(s); break; }
+            case OP_WHILE: { truthy(s, var); break; }
+
+            case OP_INT: { conv_int(s); break; }
+            case OP_DOUBLE: { conv_double(s); break; }
+            case OP_CHAR: { conv_char(s); break; }
+            case OP_STRING: { conv_string(s); break; }
+
+            case OP_DUP: { dup(s); break; }
+            case OP_POP: { release(pop(s)); break; }
+            case OP_SWAP: { swap(s); break; }
+            case OP_SPIN: { spin(s); break; }
+            case OP_NCOPY: { ncopy(s, var); break; }
+
+            case OP_EQUAL: { equal(s); break; }
+            case OP_SMALLER: { is_smaller(s); break; }
+            case OP_BIGGER: { is_bigger(s); break; }
+            case OP_LNOT: { lnot(s); break; }
+            case OP_IF: { if_else(s); break; }
+            case OP_AND: { and(s); break; }
+            case OP_OR: { or(s); break; }
+            case OP_MIN: { smaller(s); break; }
+            case OP_MAX: { bigger(s); break; }
+
+            case OP_RANGE: { range(s, var); break; }
+            case OP_DIV_NEWLINE: { div_newline(s); break; }
+            case OP_DIV_WS: { div_whitespace(s); break; }
+
+            case OP_GET_VAR: { push(s, var[i->arg]); break; }
+            case OP_SET_VAR:
+            {
+                DADOS d = pop(s);
+                var[i->arg] = d;
+                push(s, d);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Efeito de cada operação na stack: número de elementos que retira e número mínimo de elementos que coloca.
+ *
+ * As operações com `-1` elementos retirados impedem a execução em paralelo: escrevem variáveis (`:X`), fazem input (`l`, `t`), executam
+ * blocos (`w`, blocos literais) ou acedem a uma posição da stack que depende dos dados (`$`).
+ */
+static const signed char efeito[][2] =
+{
+    [OP_NOP] = {0, 0}, [OP_LIT] = {0, 1}, [OP_STR] = {0, 1}, [OP_ARRAY] = {0, 1}, [OP_BLOCK] = {-1, 0},
+    [OP_ADD] = {2, 1}, [OP_SUB] = {2, 1}, [OP_MUL] = {2, 1}, [OP_DIV] = {2, 1}, [OP_DECR] = {1, 1}, [OP_INCR] = {1, 1},
+    [OP_MOD] = {2, 1}, [OP_EXPO] = {2, 1}, [OP_MODPOW] = {3, 1},
+    [OP_BAND] = {2, 1}, [OP_BOR] = {2, 1}, [OP_BXOR] = {2, 1}, [OP_BNOT] = {1, 0},
+    [OP_LINE] = {-1, 0}, [OP_LINES] = {-1, 0}, [OP_WHILE] = {-1, 0},
+    [OP_INT] = {1, 1}, [OP_DOUBLE] = {1, 1}, [OP_CHAR] = {1, 1}, [OP_STRING] = {1, 1},
+    [OP_DUP] = {1, 2}, [OP_POP] = {1, 0}, [OP_SWAP] = {2, 2}, [OP_SPIN] = {3, 3}, [OP_NCOPY] = {-1, 0},
+    [OP_EQUAL] = {2, 1}, [OP_SMALLER] = {2, 1}, [OP_BIGGER] = {2, 1}, [OP_LNOT] = {1, 1}, [OP_IF] = {3, 1},
+    [OP_AND] = {2, 1}, [OP_OR] = {2, 1}, [OP_MIN] = {2, 1}, [OP_MAX] = {2, 1},
+    [OP_RANGE] = {1, 1}, [OP_DIV_NEWLINE] = {1, 1}, [OP_DIV_WS] = {1, 1},
+    [OP_GET_VAR] = {0, 1}, [OP_SET_VAR] = {-1, 0}
+};
+
+/**
+ * @brief Verifica se um programa pode ser executado em paralelo sobre elementos diferentes de um array.
+ *
+ * Um programa é puro quando não escreve variáveis, não faz input, não executa blocos e nunca retira elementos abaixo da profundidade
+ * inicial __base__ (simulando o número de elementos da stack instrução a instrução). Nesse caso, a execução sobre cada elemento não
+ * depende da execução sobre os restantes.
+ *
+ * - __Nota:__ As strings literais e as variáveis lidas pelo programa são fixadas com `freeze()`, para que possam ser partilhadas pelas threads.
+ *
+ * @param p Programa.
+ * @param var Array que armazena as variáveis.
+ * @param base Número de elementos na stack no início da execução.
+ * @param fim Endereço onde é guardado o número mínimo de elementos na stack no fim da execução (pode ser NULL).
+ * @return int Retorna 1 caso o programa seja puro, ou 0 caso contrário.
+ */
+int pure_program(PROGRAMA* p, DADOS *var, int base, int *fim)
+{
+    int d = base;
+
+    for (INSTRUCAO* i = p->instr; i < p->instr + p->n; i++)
+    {
+        int pops = efeito[i->op][0];
+
+        if (pops < 0 || d < pops)
+            return 0;
+        if (i->op == OP_STR && !freeze(i->lit))
+            return 0;
+        if (i->op == OP_GET_VAR && !freeze(var[i->arg]))
+            return 0;
+        if (i->op == OP_ARRAY && !pure_program(i->sub, var, 0, NULL))
+            return 0;
+
+        d += efeito[i->op][1] - pops;
+    }
+
+    if (fim != NULL)
+        *fim = d;
+    return 1;
+}
+
+/**
+ * @brief Verifica se um programa é uma única operação binária associativa (`+`, `*`, `&`, `|`, `^`, `e<` ou `e>`), que pode ser aplicada
+ * a partes de um array por qualquer ordem de agrupamento.
+ *
+ * @param p Programa.
+ * @return OPCODE Retorna a operação, ou `OP_NOP` caso o programa não seja associativo.
+ */
+OPCODE associative_op(PROGRAMA* p)
+{
+    if (p->n != 1)
+        return OP_NOP;
+
+    switch (p->instr[0].op)
+    {
+        case OP_ADD: case OP_MUL: case OP_BAND: case OP_BOR: case OP_BXOR: case OP_MIN: case OP_MAX:
+            return p->instr[0].op;
+        default:
+            return OP_NOP;
+    }
+}
+
+/**
+ * @brief Avalia um programa: compila-o e executa-o sobre a stack, alocando todos os valores temporários numa arena própria.
+ *
+ * No fim da avaliação, a stack final e as variáveis são promovidas para a arena do contexto (a arena atual no momento da chamada)
+ * e tudo o resto é libertado de uma só vez, pelo que a memória não cresce ao avaliar vários programas no mesmo processo.
+ *
+ * @param s Stack.
+ * @param var Array que armazena as variáveis.
+ * @param line Programa.
+ */
+void evaluate(STACK* s, DADOS *var, STR* line)
+{
+    ARENA* temp = new_arena();
+    ARENA* contexto = arena_switch(temp);
+
+    PROGRAMA* p = compile(line->str, line->len);
+    run_program(s, p, var);
+
+    arena_switch(contexto);
+
+    DADOS* stack = arena_alloc(sizeof(DADOS) * (s->sp + 1));
+    for (int i = 1; i <= s->sp; i++)
+        stack[i] = promote(s->stack[i]);
+    s->stack = stack;
+    s->cap = s->sp + 1;
+
+    for (int i = 0; i < 26; i++)
+        var[i] = promote(var[i]);
+
+    arena_release(temp);
+}
@@ -6,80 +6,255 @@
 #include "stack.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#define DIGITOS_EXATOS 19 ///< Número de algarismos significativos que cabem sempre num inteiro de 64 bits sem sinal.
 
 /**
- * @brief Converte um elemento para DOUBLE.
- * 
- * @param s Stack.
+ * @brief Potências de 10 exatamente representáveis num `double` (até 10^22).
  */
-void conv_double(STACK *s)
+static const double potencia10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/**
+ * @brief Verifica se um caracter é um espaço em branco (os espaços que `strtod()` e `sscanf()` ignoram antes de um número).
+ *
+ * @param c Caracter.
+ * @return int Retorna 1 caso o caracter seja um espaço em branco, ou 0 caso contrário.
+ */
+static int is_space(char c)
 {
-    DADOS d = pop(s);
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/**
+ * @brief Lê um inteiro em base 10 do início de um texto, com o mesmo resultado que `sscanf("%ld")`: os espaços iniciais são ignorados, a
+ * leitura pára no primeiro caracter que não é um algarismo e os valores fora do intervalo de um `long` são limitados aos extremos deste.
+ *
+ * @param s Texto.
+ * @param len Comprimento do texto.
+ * @return long Retorna o inteiro lido (0 caso o texto não comece por um inteiro).
+ */
+long parse_long(const char* s, long len)
+{
+    const char* fim = s + len;
+    unsigned long r = 0, limite;
+    int neg = 0, excede = 0;
+
+    while (s < fim && is_space(*s))
+        s++;
+    if (s < fim && (*s == '-' || *s == '+'))
+        neg = *s++ == '-';
+
+    limite = neg ? (unsigned long) LONG_MAX + 1 : LONG_MAX;
 
-    if (d.tipo == LONG || d.tipo == DOUBLE)
+    for (; s < fim && *s >= '0' && *s <= '9'; s++)
     {
-        double *a = d.dados;
+        unsigned d = *s - '0';
 
-        push_double(s, *a);
+        if (r > (limite - d) / 10)
+            excede = 1;
+        else
+            r = r * 10 + d;
     }
-    else if (d.tipo == CHAR)
+
+    if (excede)
+        return neg ? LONG_MIN : LONG_MAX;
+
+    return neg ? (long) (0 - r) : (long) r;
+}
+
+/**
+ * @brief Lê um número em vírgula flutuante com `strtod()`, a partir de uma cópia do texto terminada em '\0'. Utilizada nos casos que a
+ * leitura rápida não trata.
+ *
+ * @param s Texto.
+ * @param len Comprimento do texto.
+ * @return double Retorna o número lido.
+ */
+static double parse_double_slow(const char* s, long len)
+{
+    char buf[64];
+
+    if (len < (long) sizeof(buf))
+    {
+        memcpy(buf, s, len);
+        buf[len] = '\0';
+        return strtod(buf, NULL);
+    }
+
+    return strtod(new_str(s, len)->str, NULL);
+}
+
+/**
+ * @brief Lê um número em vírgula flutuante do início de um texto, com o mesmo resultado (corretamente arredondado) que `strtod()`.
+ *
+ * Os algarismos são acumulados num inteiro de 64 bits e o expoente decimal é contado à parte. Quando a mantissa é exata num `double`
+ * (até 2^53) e o expoente está entre -22 e 22, o resultado é uma única multiplicação ou divisão por uma potência de 10 exata, que é
+ * corretamente arredondada (o caminho rápido de Clinger). Os restantes casos (mais de 19 algarismos significativos, expoentes maiores,
+ * números hexadecimais, `inf` e `nan`) são lidos por `strtod()`.
+ *
+ * @param s Texto.
+ * @param len Comprimento do texto.
+ * @return double Retorna o número lido (0 caso o texto não comece por um número).
+ */
+double parse_double(const char* s, long len)
+{
+    const char *p = s, *fim = s + len;
+    uint64_t m = 0;
+    int neg = 0, algarismos = 0, digitos = 0;
+    long expoente = 0;
+
+    while (p < fim && is_space(*p))
+        p++;
+    if (p < fim && (*p == '-' || *p == '+'))
+        neg = *p++ == '-';
+
+    for (; p < fim && *p >= '0' && *p <= '9'; p++, digitos++)
     {
-        char *a = d.dados;
+        if (m == 0 && *p == '0')
+            continue;
+        if (algarismos++ < DIGITOS_EXATOS)
+            m = m * 10 + (*p - '0');
+        else
+            expoente++;
+    }
 
-        double r = *a;
-        push_double(s, r);
+    if (p < fim && *p == '.')
+    {
+        for (p++; p < fim && *p >= '0' && *p <= '9'; p++, digitos++)
+        {
+            if (m == 0 && *p == '0')
+                expoente--;
+            else if (algarismos++ < DIGITOS_EXATOS)
+            {
+                m = m * 10 + (*p - '0');
+                expoente--;
+            }
+        }
     }
-    else if (d.tipo == STRING)
+
+    if (digitos == 0 || algarismos > DIGITOS_EXATOS || (p < fim && (*p == 'x' || *p == 'X')))
+        return parse_double_slow(s, len);
+
+    if (p + 1 < fim && (*p == 'e' || *p == 'E'))
+    {
+        const char *q = p + 1;
+        int neg_e = 0;
+        long e = 0;
+
+        if (*q == '-' || *q == '+')
+            neg_e = *q++ == '-';
+        if (q < fim && *q >= '0' && *q <= '9')
+        {
+            for (; q < fim && *q >= '0' && *q <= '9'; q++)
+                if (e < 100000)
+                    e = e * 10 + (*q - '0');
+            expoente += neg_e ? -e : e;
+        }
+    }
+
+    double r = m;
+
+    if (m == 0)
+        r = 0;
+    else if (m <= (1ULL << 53) && expoente >= 0 && expoente <= 22)
+        r *= potencia10[expoente];
+    else if (m <= (1ULL << 53) && expoente < 0 && expoente >= -22)
+        r /= potencia10[-expoente];
+    else if (expoente != 0)
+        return parse_double_slow(s, len);
+
+    return neg ? -r : r;
+}
+
+/**
+ * @brief Converte de uma só vez todas as strings de um array (por exemplo, o resultado de `S/`) em números, como `{ i } %` ou `{ f } %`.
+ *
+ * @param array Array.
+ * @param inteiros 1 para converter para LONG (`i`), ou 0 para converter para DOUBLE (`f`).
+ * @return STACK* Retorna um array `LONGS` ou `DOUBLES` com os números lidos, ou NULL caso algum elemento não seja uma string (ou, em
+ * `i`, contenha um inteiro que não cabe num `long`, caso em que as strings são convertidas uma a uma).
+ */
+STACK* parse_strings(STACK* array, int inteiros)
+{
+    long n = array->sp;
+
+    if (array->formato != GENERICO)
+        return NULL;
+    for (long i = 1; i <= n; i++)
+        if (array->stack[i].tipo != STRING)
+            return NULL;
+
+    STACK *r = new_array(inteiros ? LONGS : DOUBLES, n);
+
+    for (long i = 1; i <= n; i++)
     {
-        char *a = d.dados;
+        STR *a = array->stack[i].dados;
 
-        double r;
-        sscanf(a, "%lf", &r);
-        push_double(s, r);
+        if (inteiros)
+        {
+            DADOS d = big_parse(a->str, a->len);
+
+            if (d.tipo != LONG)
+                return NULL;
+            r->longs[i] = d.l;
+        }
+        else
+            r->doubles[i] = parse_double(a->str, a->len);
     }
 
-    free(d.dados);
+    r->sp = n;
+    return r;
 }
 
 /**
- * @brief Converte um elemento para inteiro (LONG).
+ * @brief Converte um elemento para DOUBLE.
  * 
  * @param s Stack.
  */
-void conv_int(STACK *s)
+void conv_double(STACK *s)
 {
     DADOS d = pop(s);
-    
-    if (d.tipo == LONG)
-    {
-        double *a = d.dados;
 
-        push_long(s, *a);
+    if (d.tipo == LONG || d.tipo == DOUBLE || d.tipo == CHAR || d.tipo == BIGINT)
+    {
+        push_double(s, to_double(d));
     }
-    else if (d.tipo == CHAR)
+    else if (d.tipo == STRING)
     {
-        char *a = d.dados;
-        long ri = *a;
+        STR *a = d.dados;
 
-        double r = ri;
-        push_long(s, r);
+        push_double(s, parse_double(a->str, a->len));
     }
-    else if (d.tipo == DOUBLE)
-    {
-        double *a = d.dados;
-        long ri = *a;
+}
 
-        double r = ri;
-        push_long(s, r);
+/**
+ * @brief Converte um elemento para inteiro (LONG, ou BIGINT caso a string lida contenha um inteiro que não cabe num `long`).
+ * 
+ * @param s Stack.
+ */
+void conv_int(STACK *s)
+{
+    DADOS d = pop(s);
+    
+    if (d.tipo == LONG || d.tipo == BIGINT)
+    {
+        push(s, d);
+    }
+    else if (d.tipo == CHAR || d.tipo == DOUBLE)
+    {
+        push_long(s, to_long(d));
     }
     else if (d.tipo == STRING)
     {
-        char *a = d.dados;
-        long ri;
-        sscanf(a, "%ld", &ri);
+        STR *a = d.dados;
 
-        double r = ri;
-        push_long(s, r);
+        push(s, big_parse(a->str, a->len));
     }
 }
 
@@ -92,27 +267,134 @@ void conv_char(STACK *s)
 {
     DADOS d = pop(s);
 
-    if (d.tipo == LONG)
+    if (d.tipo == LONG || d.tipo == BIGINT)
     {
-        double *ai = d.dados;
-        long a = *ai;
-        
-        char r = a;
+        char r = to_long(d);
         push_char(s, r);
     }
     else if (d.tipo == DOUBLE)
     {
-        double *a = d.dados;
-
-        char r = *a;
+        char r = d.n;
         push_char(s, r);
     }
     else if (d.tipo == CHAR)
     {
         push(s, d);
     }
+}
+
+/**
+ * @brief Escreve um número em vírgula flutuante com o mesmo resultado que `printf("%f")` (6 casas decimais).
+ *
+ * A parte inteira é escrita como um inteiro e as 6 casas decimais são obtidas da parte fracionária (separada sem erro) com uma única
+ * multiplicação. Os números que não cabem num inteiro de 64 bits, `inf`, `nan` e os valores quase a meio de dois resultados possíveis
+ * (cujo arredondamento podia ser diferente do de `printf()`) não são tratados.
+ *
+ * @param x Número.
+ * @param b Buffer onde é escrito o resultado (com pelo menos 32 caracteres).
+ * @return int Retorna o número de caracteres escritos, ou -1 caso o número tenha de ser formatado por `snprintf()`.
+ */
+static int format_f(double x, char *b)
+{
+    double a = fabs(x);
+
+    if (!(a < 9e18))
+        return -1;
+
+    double inteira = floor(a);
+    double y = (a - inteira) * 1e6;
+    double r = floor(y);
+
+    if (fabs(y - r - 0.5) < 1e-6)
+        return -1;
+
+    unsigned long ip = inteira;
+    long m = (long) r + (y - r > 0.5);
+    char *p = b;
+
+    if (m == 1000000)
+    {
+        ip++;
+        m = 0;
+    }
+
+    if (signbit(x))
+        *p++ = '-';
+
+    char t[24];
+    char *q = t + sizeof(t);
+
+    do
+    {
+        *--q = '0' + ip % 10;
+        ip /= 10;
+    } while (ip != 0);
+
+    memcpy(p, q, t + sizeof(t) - q);
+    p += t + sizeof(t) - q;
+    *p++ = '.';
+    for (int i = 5; i >= 0; i--, m /= 10)
+        p[i] = '0' + m % 10;
+
+    return p + 6 - b;
+}
+
+/**
+ * @brief Converte um número ou um caracter numa nova string, com o mesmo resultado que `printf("%ld")`, `printf("%f")` ou `printf("%c")`.
+ *
+ * A string é alocada com o tamanho exato do resultado.
+ *
+ * @param d Elemento do tipo LONG, DOUBLE, BIGINT ou CHAR.
+ * @return STR* Retorna a nova string.
+ */
+STR* number_to_str(DADOS d)
+{
+    char b[32];
+    int n;
+
+    if (d.tipo == CHAR)
+        return new_str(&d.c, 1);
+    if (d.tipo == LONG)
+        return new_str(b, format_long(d.l, b));
+    if (d.tipo == BIGINT)
+        return big_to_str(d.dados);
+
+    n = format_f(d.n, b);
+    if (n >= 0)
+        return new_str(b, n);
+
+    STR *r = new_str_cap(snprintf(NULL, 0, "%f", d.n));
+    r->len = snprintf(r->str, r->cap + 1, "%f", d.n);
+    return r;
+}
+
+/**
+ * @brief Converte de uma só vez todos os números de um array em strings, como `{ s } %`.
+ *
+ * @param array Array (compacto, intervalo, ou genérico apenas com números e caracteres).
+ * @return STACK* Retorna o array de strings, ou NULL caso algum elemento não seja um número nem um caracter.
+ */
+STACK* format_strings(STACK* array)
+{
+    long n = array->sp;
+    DADOS d;
+
+    if (array->formato == GENERICO)
+        for (long i = 1; i <= n; i++)
+            if (array->stack[i].tipo != LONG && array->stack[i].tipo != DOUBLE && array->stack[i].tipo != CHAR && array->stack[i].tipo != BIGINT)
+                return NULL;
+
+    STACK *r = new_stack_cap(n);
+
+    d.tipo = STRING;
+    for (long i = 1; i <= n; i++)
+    {
+        d.dados = number_to_str(array->formato == GENERICO ? array->stack[i] : array_get(array, i));
+        r->stack[i] = d;
+    }
 
-    free(d.dados);
+    r->sp = n;
+    return r;
 }
 
 /**
@@ -124,37 +406,12 @@ void conv_string(STACK *s)
 {
     DADOS d = pop(s);
 
-    if (d.tipo == LONG)
-    {
-        char result[BUFSIZ];
-        double *ai = (double*)d.dados;
-
-        long a = *ai;
-        sprintf(result, "%ld", a);
-        push_string(s, result);
-    }
-    else if (d.tipo == DOUBLE)
-    {
-        char result[BUFSIZ];
-        double *a = (double*)d.dados;
-
-        sprintf(result, "%lf", *a);
-        push_string(s, result);
-    }
-    else if (d.tipo == CHAR)
+    if (d.tipo == LONG || d.tipo == DOUBLE || d.tipo == CHAR || d.tipo == BIGINT)
     {
-        char result[BUFSIZ];
-        char *l = (char*)d.dados;
-        
-        result[0] = *l;
-        result[1] = '\0';
-        push_string(s, result);
+        push_string(s, number_to_str(d));
     }
     else if (d.tipo == STRING)
     {
-        char *str = (char*)d.dados;
-        push_string(s, str);
+        push_string(s, d.dados);
     }
-
-    free(d.dados);
 }
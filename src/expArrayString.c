@@ -2,8 +2,7 @@
  * @file expArrayString.c
  * @brief Operações com Arrays e Strings.
  * 
- * - __Nota:__ Todas as funções em expArrayString.c incluem uma libertação de memória (ex: `free(x.dados)`) uma vez que acedemos a um elemento da stack com
- * a função `pop()` para o qual foi alocada memória dinâmica que já não será usada.
+ * - __Nota:__ Os números e os caracteres são guardados diretamente nos elementos dos arrays, pelo que concatená-los não aloca memória para cada elemento.
  */
 
 #include "stack.h"
@@ -14,90 +13,74 @@
 // Colocação de elementos na stack
 
 /**
- * @brief Lê o input e cria um array.
+ * @brief Cria um array, executando numa nova stack o programa compilado a partir do conteúdo do array literal.
+ * 
+ * Um array que só contenha números do mesmo tipo é guardado no formato compacto (`pack()`).
  * 
  * @param s Stack.
- * @param token Input.
+ * @param p Programa que constrói o conteúdo do array.
  * @param var Array de variáveis.
- * @return DADOS Retorna o array criado.
  */
-DADOS create_array(STACK* s, char* token, DADOS *var)
+void create_array(STACK* s, PROGRAMA* p, DADOS *var)
 {
     STACK* array = new_stack();
-    char token_token[BUFSIZ]; 
+    run_program(array, p, var);
+    pack(array);
+
+    push_array(s, array);
+}
+
+/**
+ * @brief Separa uma string em substrings delimitadas por qualquer um dos caracteres de __delim__, ignorando as substrings vazias, e coloca
+ * na stack um array com as substrings. Função auxiliar a `div_newline()` e `div_whitespace()`.
+ * 
+ * @param s Stack.
+ * @param delim Caracteres delimitadores.
+ * @param n Número de caracteres delimitadores (um '\0' na string só é delimitador caso esteja entre eles).
+ */
+void split_chars(STACK *s, const char *delim, int n)
+{
+    STR *a = pop(s).dados;
+    STACK *r = new_stack();
+    long i = 0, ini;
 
-    ++token;
-    while(*token){
-        token = get_token(token, token_token);
+    while (i < a->len)
+    {
+        for (; i < a->len && memchr(delim, a->str[i], n); i++);
+        for (ini = i; i < a->len && !memchr(delim, a->str[i], n); i++);
 
-        if (token_token[0] == ']');  //Não faz nada
-        else {
-            handle_token(array, token_token, var);
-        }
+        if (i > ini)
+            push_string(r, new_str(a->str + ini, i - ini));
     }
 
-    DADOS d = {ARRAY, array};
-    s->sp++;
-    s->stack[s->sp] = d;
-    return d;
+    push_array(s, r);
 }
 
 /**
  * @brief Separa uma string em substrings de acordo com o caracter '\n' (parágrafo), adicionando cada substring a um array que é
- * posteriormente colocado na stack com a função `push_array()`. Como o tipo ARRAY é definido por uma stack, é utilizada a função `new_stack()`
- * para inicializar o "array".
+ * posteriormente colocado na stack com a função `push_array()`.
  * 
  * @param s Stack.
  */
 void div_newline(STACK *s)
 {
-    char *a = pop(s).dados;
-    char *str = malloc(sizeof(char) * BUFSIZ);
-    strcpy(str, a);
-
-    char *token = malloc(sizeof(char) * strlen(a));
-    STACK *r = new_stack();
-    
-    token = strtok(str, "\n");
-
-    while (token != NULL)
-    {
-        push_string(r, token);
-        token = strtok(NULL, "\n");
-    }
-    
-    push_array(s, *r);
+    split_chars(s, "\n", 1);
 }
 
 /**
- * @brief Separa uma string em substrings de acordo com o caracter ' ' (espaço), adicionando cada substring a um array que é
- * posteriormente colocado na stack com a função `push_array()`. Como o tipo ARRAY é definido por uma stack, é utilizada a função `new_stack()`
- * para inicializar o "array".
+ * @brief Separa uma string em substrings de acordo com os caracteres de espaçamento (' ', '\t', '\n', ...), adicionando cada substring a um
+ * array que é posteriormente colocado na stack com a função `push_array()`.
  * 
  * @param s Stack.
  */
 void div_whitespace(STACK *s)
 {
-    char *a = pop(s).dados;
-    char *str = malloc(sizeof(char) * BUFSIZ);
-    strcpy(str, a);
-    
-    char *token = malloc(sizeof(char) * strlen(a));
-    STACK *r = new_stack();
-    
-    token = strtok(str, " \t\r\n\v\f");
-
-    while (token != NULL)
-    {
-        push_string(r, token);
-        token = strtok(NULL, " \t\r\n\v\f");
-    }
-    
-    push_array(s, *r);
+    split_chars(s, " \t\r\n\v\f", 6);
 }
 
 /**
  * @brief Quando o input é um inteiro N, cria um ARRAY de inteiros com os elementos no intervalo de 0 até N-1, e coloca-o na stack com a função `push_array()`
+ * (um `INTERVALO`, cujos elementos não são guardados, pelo que o custo não depende de N).
  * Caso o input seja um ARRAY, devolve à stack o tamanho do mesmo na forma de inteiro (LONG), utilizando `push_long()`.
  * 
  * - __Nota:__ Quando o input é um bloco (BLOCK), realiza a operação de filtragem de arrays/strings de acordo com um bloco, utilizando por
@@ -112,13 +95,7 @@ void range(STACK *s, DADOS *var)
     
     if (x.tipo == LONG)
     {
-        double *a = x.dados;
-        STACK *r = new_stack();
-
-        for (int i=0; i < *a; i++)
-            push_long(r, i);
-
-        push_array(s, *r);
+        push_array(s, new_range(0, 1, x.l));
     }
     else if (x.tipo == ARRAY)
     {
@@ -129,10 +106,7 @@ void range(STACK *s, DADOS *var)
     }
     else if (x.tipo == STRING)
     {
-        char* str = x.dados;
-        int i;
-        for (i = 0; *(str + i); ++i);
-        push_long(s, i);
+        push_long(s, ((STR*)x.dados)->len);
     }
     else if (x.tipo == BLOCK)
     {
@@ -142,30 +116,22 @@ void range(STACK *s, DADOS *var)
             filter_array(s, x, y, var);
         else
             filter_string(s, x, y, var);
-
-        free(y.dados);
     }
 }
 
 /**
  * @brief Responsável por criar uma nova string, de acordo com o input do programa, que é feito da forma: `"string de exemplo"`.
  * 
- * @param s Stack.
- * @param token Input do programa.
+ * @param s Conteúdo da string (o texto entre as aspas).
+ * @param len Comprimento da string.
+ * @return DADOS Retorna a string criada, que é guardada como literal no programa compilado (e partilhada por todas as execuções deste).
  */
-void create_string(STACK *s, char* token)
+DADOS create_string(const char* s, int len)
 {
-    ++token;
-    char* str = malloc(sizeof(char) * BUFSIZ);
-    int i;
-
-    for (i = 0; *(token + i) != '"'; ++i)
-    {
-        *(str+i) = *(token+i); 
-    }
-    *(str+i) = '\0';
-
-    push_string(s, str);
+    DADOS d;
+    d.tipo = STRING;
+    d.dados = new_str(s, len);
+    return d;
 }
 
 /**
@@ -183,64 +149,50 @@ void create_string(STACK *s, char* token)
  */
 void slash_str(STACK* s, DADOS a, DADOS b)
 {
-    char *str2 = a.dados;
-    char *str1 = b.dados;
+    STR *str2 = a.dados;
+    STR *str1 = b.dados;
     
     STACK *r = new_stack();
     
-    int ind;
-    while (strstr(str1, str2) != NULL)
+    long ini = 0, ind;
+    while (str2->len > 0 && (ind = str_find(str1, str2->str, str2->len, ini)) >= 0)
     {
-        char *aux = malloc(sizeof(char) * BUFSIZ);
-        ind = strstr(str1, str2) - str1;
+        push_string(r, new_str(str1->str + ini, ind - ini));
+        ini = ind + str2->len;
+    }
+    if (ini < str1->len)
+        push_string(r, new_str(str1->str + ini, str1->len - ini));
 
-        int i;
-        for (i=0; i < ind; i++)
-            aux[i] = str1[i];
-        aux[i] = '\0';
+    push_array(s, r);
+}
 
-        push_string(r, aux);
-        str1 = str1 + ind + strlen(str2);
-    }
-    if (str1[0] != '\0')
-    {
-        char *aux = malloc(sizeof(char) * BUFSIZ);
-        strcpy(aux, str1);
-        push_string(r, aux);
-    }
+/**
+ * @brief Cria um array com um único elemento (no formato compacto, caso seja um número), para ser concatenado a outro array.
+ * 
+ * @param d Elemento.
+ * @return STACK* Retorna o endereço do novo array.
+ */
+STACK* elem_array(DADOS d)
+{
+    STACK *r = new_stack_cap(1);
 
-    push_array(s, *r);
+    push(r, d);
+    pack(r);
+    return r;
 }
 
 /**
  * @brief Concatena dois arrays. Função auxiliar a `s_add()`.
  * 
+ * Os arrays grandes não são copiados: o resultado é uma árvore que partilha os elementos de ambos (ver `array_concat()`).
+ * 
  * @param s Stack.
  * @param x Array 1.
  * @param y Array 2.
  */
 void add_arrays(STACK *s, DADOS x, DADOS y)
 {
-    STACK *array1 = y.dados;
-    STACK *array2 = x.dados;
-
-    STACK *r = new_stack();
-
-    int i,j,k;
-
-    for (i=1; i <= array1->sp; i++)
-    {
-        *(r->stack + i) = *(array1->stack + i);
-        r->sp++;
-    }
-
-    for (j=i,k=1;k <= array2->sp;j++,k++)
-    {
-        *(r->stack + j) = *(array2->stack + k);
-        r->sp++;
-    }
-
-    push_array(s, *r);
+    push_array(s, array_concat(y.dados, x.dados));
 }
 
 /**
@@ -253,41 +205,9 @@ void add_arrays(STACK *s, DADOS x, DADOS y)
 void add_char_array(STACK *s, DADOS x, DADOS y)
 {
     if (x.tipo == CHAR && y.tipo == ARRAY)
-    {
-        STACK *array = y.dados;
-        char *a = x.dados;
-        double c = *a;
-
-        STACK *r = new_stack();
-
-        int i;
-        for (i=1; i <= array->sp; i++)
-        {
-            *(r->stack + i) = *(array->stack + i);
-            r->sp++;
-        }
-
-        push_char(r, c);
-        push_array(s, *r);
-    }
+        push_array(s, array_concat(y.dados, elem_array(x)));
     else if (x.tipo == ARRAY && y.tipo == CHAR)
-    {
-        STACK *array = x.dados;
-        char *a = y.dados;
-        double c = *a;
-
-        STACK *r = new_stack();
-        int i;
-
-        push_char(r,c);
-
-        for (i=2; i <= array->sp + 1; i++)
-        {
-            *(r->stack + i) = *(array->stack + i -1);
-            r->sp++;
-        }
-        push_array(s, *r);
-    }
+        push_array(s, array_concat(elem_array(y), x.dados));
 }
 
 /**
@@ -299,42 +219,28 @@ void add_char_array(STACK *s, DADOS x, DADOS y)
  */
 void add_num_array(STACK *s, DADOS x, DADOS y)
 {
-    if ((x.tipo == LONG || x.tipo == DOUBLE) && y.tipo == ARRAY)
-    {
-        STACK *array = y.dados;
-        push(array, x);
-        push_array(s, *array);
-    }
-    else if (x.tipo == ARRAY && (y.tipo == LONG || y.tipo == DOUBLE))
-    {
-        STACK *array = x.dados;
-        STACK *r = new_stack();
-        
-        push(r, y);
-        int i;
-        for (i=2; i <= array->sp + 1; i++)
-        {
-            *(r->stack + i) = *(array->stack + i -1);
-            r->sp++;
-        }
-        push_array(s, *r);
-    }
+    if ((x.tipo == LONG || x.tipo == DOUBLE || x.tipo == BIGINT) && y.tipo == ARRAY)
+        push_array(s, array_concat(y.dados, elem_array(x)));
+    else if (x.tipo == ARRAY && (y.tipo == LONG || y.tipo == DOUBLE || y.tipo == BIGINT))
+        push_array(s, array_concat(elem_array(y), x.dados));
 }
 
 /**
  * @brief Concatena duas strings. Função auxiliar a `s_add()`.
  * 
+ * A segunda string é acrescentada à primeira com `str_concat()`, que só copia a primeira string quando não a pode prolongar, pelo que
+ * concatenar repetidamente ao fim de uma string tem custo linear (mesmo que a string esteja guardada numa variável).
+ * 
  * @param s Stack.
  * @param x String 1.
  * @param y String 2.
  */
 void add_strings(STACK *s, DADOS x, DADOS y)
 {
-    char* r = malloc(sizeof(x.dados) + sizeof(y.dados) + sizeof(char) + BUFSIZ);
-    char* a = x.dados;
-    char* b = y.dados;
-    memcpy(r, b, strlen(b));
-    strcat(r, a);
+    STR *a = x.dados;
+    STR *r = str_concat(&y, a->str, a->len);
+
+    release(x);
     push_string(s, r);
 }
 
@@ -349,43 +255,16 @@ void add_char_string(STACK *s, DADOS x, DADOS y)
 {
     if (x.tipo == CHAR && y.tipo == STRING)
     {
-        char *a = x.dados;
-        double c = *a;
-
-        char *str = y.dados;
-        char *r = malloc (sizeof(x.dados) + sizeof(y.dados) + sizeof(char));
-        int tam = strlen(str);
-        
-        int i;
-        for (i=0; *(str + i); i++)
-        {
-            *(r+i) = *(str + i);
-        }
-
-        *(r + tam) = c;
-        *(r + tam + 1) = '\0';
-
-        push_string (s, r);
+        push_string(s, str_concat(&y, &x.c, 1));
     }
     else if (x.tipo == STRING && y.tipo == CHAR)
     {
-        char *a = y.dados;
-        double c = *a;
-
-        char *str = x.dados;
-        char *r = malloc (sizeof(x.dados) + sizeof(y.dados) + sizeof(char));
-        int tam = strlen(str);
-        int i,j=0;
-
-        *r = c;
-
-        for (i=1; *(str + j); i++,j++)
-        {
-            *(r+i) = *(str + j);
-        }
+        STR *str = x.dados;
+        STR *r = new_str_cap(str->len + 1);
 
-        *(r + tam + 1) = '\0';
-        
-        push_string (s, r);
+        str_append(r, &y.c, 1);
+        str_append(r, str->str, str->len);
+        release(x);
+        push_string(s, r);
     }
 }
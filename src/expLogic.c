@@ -2,8 +2,7 @@
  * @file expLogic.c
  * @brief Operações de lógica.
  * 
- * - __Nota:__ Todas as funções em expLogic.c incluem uma libertação de memória (ex: `free(x.dados)`) uma vez que acedemos a um elemento da stack com
- * a função `pop()` para o qual foi alocada memória dinâmica que já não será usada.
+ * - __Nota:__ Os operandos numéricos são guardados diretamente nos elementos da stack, pelo que as comparações não alocam nem libertam memória.
  */
 
 #include "stack.h"
@@ -11,11 +10,33 @@
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * @brief Compara os valores numéricos de dois elementos. Dois inteiros (LONG ou BIGINT) são comparados exatamente; nos restantes casos são
+ * comparados os valores obtidos com `to_double()`.
+ * 
+ * @param a Elemento.
+ * @param b Elemento.
+ * @return int Retorna um valor negativo, zero ou positivo, caso __a__ seja menor, igual ou maior que __b__ (zero caso algum dos valores seja
+ * `nan`, tal como as comparações `<` e `>`).
+ */
+int num_compare(DADOS a, DADOS b)
+{
+    if (a.tipo == LONG && b.tipo == LONG)
+        return (a.l > b.l) - (a.l < b.l);
+    if (is_integer(a) && is_integer(b))
+        return big_compare(a, b);
+
+    double x = to_double(a);
+    double y = to_double(b);
+
+    return (x > y) - (x < y);
+}
+
 /**
  * @brief Verifica se dois elementos da stack são iguais, retornando 1 caso sejam e 0 caso contrário (True ou False).
  * 
  * - __Nota:__ Caso o primeiro operando do input seja um ARRAY, a função `equal()` retira do mesmo o elemento que se encontra no
- * indíce fornecido pelo segundo operando e coloca-o na stack. 
+ * indíce fornecido pelo segundo operando e coloca-o na stack (um índice fora do array é um erro, ver `check_index()`). Duas strings são iguais quando têm o mesmo comprimento e os mesmos caracteres.
  * 
  * @param s Stack.
  */
@@ -26,34 +47,35 @@ void equal(STACK *s)
 
     if (y.tipo == ARRAY && x.tipo == LONG)
     {
-        double *i = x.dados;
-        long ind = *i;
+        long ind = check_index(x.l, ((STACK*)y.dados)->sp);
         STACK *array = y.dados;
 
-        push(s, array->stack[ind+1]);
-        free(x.dados);
+        push(s, array_get(array, ind+1));
     }
     else if (y.tipo == STRING && x.tipo == LONG)
     {
-        double *i = x.dados;
-        long ind = *i;
-        char* str = y.dados;
+        long ind = check_index(x.l, ((STR*)y.dados)->len);
+        STR* str = y.dados;
 
-        push_char(s, *(str+ind));
-        free(x.dados);
+        push_char(s, str->str[ind]);
     }
+    else if (y.tipo == STRING && x.tipo == STRING)
+    {
+        if (str_compare(y.dados, x.dados) == 0)
+            push_long(s, 1);
+        else
+            push_long(s, 0);
+    }
+    else if (y.tipo == LONG && x.tipo == LONG)
+        push_long(s, y.l == x.l);
+    else if (is_integer(y) && is_integer(x))
+        push_long(s, big_compare(y, x) == 0);
     else
     {
-        double *a = x.dados;
-        double *b = y.dados;
-
-        if (*b == *a)
+        if (to_double(y) == to_double(x))
             push_long(s, 1);
         else
             push_long(s, 0);
-
-        free(x.dados);
-        free(y.dados);
     }
 }
 
@@ -74,10 +96,7 @@ void is_smaller(STACK *s)
     {
         case 'S':
         {
-            char *a = x.dados;
-            char *b = y.dados;
-
-            if (strcmp (b, a) > 0)
+            if (cy != 'S' || str_compare(y.dados, x.dados) > 0)
                 push_long(s, 0);
             else
                 push_long(s, 1);
@@ -90,31 +109,25 @@ void is_smaller(STACK *s)
             {
                 case 'A':
                 {
-                    double *ii = x.dados;
-                    int i = *ii;
+                    long i = x.l;
                     STACK *array = y.dados;
 
-                    STACK *r = new_stack();
-                    
-                    for (int j = 1; j <= i; j++)
-                        push(r, array->stack[j]);
+                    if (i > array->sp)
+                        i = array->sp;
+                    if (i < 0)
+                        i = 0;
 
-                    push_array(s, *r);
+                    push_array(s, array_slice(array, 1, i));
 
                     return;
                 }
                 case 'S':
                 {
-                    double *ii = x.dados;
-                    int i = *ii;
-                    char *str = y.dados;
+                    STR *r = y.dados;
+                    long i = x.l;
 
-                    char *r = malloc(sizeof(str) + BUFSIZ);
-
-                    int j;
-                    for (j = 0; j < i; j++)
-                        r[j] = str[j];
-                    r[j] = '\0';
+                    if (i < r->len)
+                        r = str_slice(&y, 0, i > 0 ? i : 0);
 
                     push_string(s, r);
 
@@ -122,10 +135,7 @@ void is_smaller(STACK *s)
                 }
                 default:
                 {
-                    double a_int = *(double*)x.dados;
-                    double b_int = *(double*)y.dados;
-
-                    if (b_int < a_int)
+                    if (num_compare(y, x) < 0)
                         push_long(s, 1);
                     else
                         push_long(s, 0);
@@ -137,10 +147,7 @@ void is_smaller(STACK *s)
         }
         default:
         {
-            double a_int = *(double*)x.dados;
-            double b_int = *(double*)y.dados;
-
-            if (b_int < a_int)
+            if (num_compare(y, x) < 0)
                 push_long(s, 1);
             else
                 push_long(s, 0);
@@ -167,10 +174,7 @@ void is_bigger(STACK *s)
     {
         case 'S':
         {
-            char *a = x.dados;
-            char *b = y.dados;
-
-            if (strcmp (b, a) > 0)
+            if (cy != 'S' || str_compare(y.dados, x.dados) > 0)
                 push_long(s, 1);
             else
                 push_long(s, 0);
@@ -183,31 +187,28 @@ void is_bigger(STACK *s)
             {
                 case 'A':
                 {
-                    double *ii = x.dados;
-                    int i = *ii;
+                    long i = x.l;
                     STACK *array = y.dados;
 
-                    STACK *r = new_stack();
+                    if (i > array->sp)
+                        i = array->sp;
+                    if (i < 0)
+                        i = 0;
 
-                    for (int j = array->sp - i + 1; j <= array->sp; j++)
-                        push(r, array->stack[j]);
-
-                    push_array(s, *r);
+                    push_array(s, array_slice(array, array->sp - i + 1, i));
 
                     return;
                 }
                 case 'S':
                 {
-                    double *ii = x.dados;
-                    int i = *ii;
-                    char *str = y.dados;
-
-                    char *r = malloc(sizeof(str) + BUFSIZ);
+                    STR *r = y.dados;
+                    long i = x.l;
 
-                    int j, k, tam = strlen(str);
-                    for (j = tam - i, k = 0; j < tam; j++, k++)
-                        r[k] = str[j];
-                    r[k] = '\0';
+                    if (i < r->len)
+                    {
+                        long k = r->len - (i > 0 ? i : 0);
+                        r = str_slice(&y, k, r->len - k);
+                    }
 
                     push_string(s, r);
 
@@ -215,10 +216,7 @@ void is_bigger(STACK *s)
                 }
                 default:
                 {
-                    double a_int = *(double*)x.dados;
-                    double b_int = *(double*)y.dados;
-
-                    if (b_int > a_int)
+                    if (num_compare(y, x) > 0)
                         push_long(s, 1);
                     else
                         push_long(s, 0);
@@ -230,10 +228,7 @@ void is_bigger(STACK *s)
         }
         default:
         {
-            double a_int = *(double*)x.dados;
-            double b_int = *(double*)y.dados;
-
-            if (b_int > a_int)
+            if (num_compare(y, x) > 0)
                 push_long(s, 1);
             else
                 push_long(s, 0);
@@ -250,14 +245,12 @@ void is_bigger(STACK *s)
  */
 void lnot(STACK *s)
 {
-    double *a = pop(s).dados;
+    double a = to_double(pop(s));
 
-    if (*a == 0)
+    if (a == 0)
         push_long(s, 1);
     else
         push_long(s, 0);
-
-    free(a);
 }
 
 /**
@@ -269,16 +262,13 @@ void and(STACK *s)
 {
     DADOS x = pop(s);
 
-    double *a = x.dados;
-    double *b = pop(s).dados;
+    double a = to_double(x);
+    double b = to_double(pop(s));
 
-    if (*a != 0 && *b != 0)
+    if (a != 0 && b != 0)
         push(s, x);
     else
         push_long(s, 0);
-
-    free(a);
-    free(b);
 }
 
 /**
@@ -295,32 +285,32 @@ void bigger (STACK *s)
     {
         int tam_a = 0;
         int tam_b = 0;
-        char* str1 = a.dados;
-        char* str2 = b.dados;
+        STR* str1 = a.dados;
+        STR* str2 = b.dados;
 
-        for (int i = 0; *(str2+i); ++i)
-            tam_b += *(str2+i);
-        for (int i = 0; *(str2 + i); ++i)
-            tam_a += *(str1 + i);
+        for (long i = 0; i < str2->len; ++i)
+            tam_b += str2->str[i];
+        for (long i = 0; i < str1->len; ++i)
+            tam_a += str1->str[i];
         
         if (tam_b > tam_a)
+        {
+            release(a);
             push_string(s, str2);
+        }
         else
+        {
+            release(b);
             push_string(s, str1);
+        }
     }
     else 
     {
-        double x = *(double*)a.dados;
-        double y = *(double*)b.dados;
-
-        if (y > x)
+        if (num_compare(b, a) > 0)
             push(s, b);
         else
             push(s, a);
     }
-
-    free(a.dados);
-    free(b.dados);
 }
 
 /**
@@ -337,32 +327,32 @@ void smaller (STACK *s)
     {
         int tam_a = 0;
         int tam_b = 0;
-        char* str1 = a.dados;
-        char* str2 = b.dados;
+        STR* str1 = a.dados;
+        STR* str2 = b.dados;
 
-        for (int i = 0; *(str2+i); ++i)
-            tam_b += *(str2+i);
-        for (int i = 0; *(str2 + i); ++i)
-            tam_a += *(str1 + i);
+        for (long i = 0; i < str2->len; ++i)
+            tam_b += str2->str[i];
+        for (long i = 0; i < str1->len; ++i)
+            tam_a += str1->str[i];
         
         if (tam_b < tam_a)
+        {
+            release(a);
             push_string(s, str2);
+        }
         else
+        {
+            release(b);
             push_string(s, str1);
+        }
     }
     else 
     {
-        double x = *(double*)a.dados;
-        double y = *(double*)b.dados;
-
-        if (y < x)
+        if (num_compare(b, a) < 0)
             push(s, b);
         else
             push(s, a);
     }
-
-    free(a.dados);
-    free(b.dados);
 }
 
 /**
@@ -376,18 +366,15 @@ void or (STACK *s)
     DADOS x = pop(s);
     DADOS y = pop(s);
 
-    double *a = x.dados;
-    double *b = y.dados;
+    double a = to_double(x);
+    double b = to_double(y);
 
-    if (*a == 0 && *b == 0)
+    if (a == 0 && b == 0)
         push_long(s, 0);
-    else if (*b == 0)
+    else if (b == 0)
         push(s, x);
     else
         push(s, y);
-    
-    free(a);
-    free(b);
 }
 
 /**
@@ -407,32 +394,48 @@ void if_else (STACK* s)
     {
         STACK* arr = if_this.dados; 
         if(arr->sp > 1)
-        {
             push(s, then_this);
-            free(if_this.dados);
-            free(else_this.dados);
-        }
         else 
-        {
             push(s, else_this);
-            free(if_this.dados);
-            free(then_this.dados);
-        }
     }
     else
     {
-        double *a = if_this.dados;
-        if (*a != 0)
-        {
+        if (to_double(if_this) != 0)
             push(s, then_this);
-            free(if_this.dados);
-            free(else_this.dados);
-        }
         else
-        {
             push(s, else_this);
-            free(if_this.dados);
-            free(then_this.dados);
+    }
+}
+
+/**
+ * @brief Compara dois elementos, definindo a ordem utilizada na ordenação (operador `$` com um bloco).
+ * 
+ * Os números e os caracteres são comparados pelo seu valor, as strings lexicograficamente e os arrays lexicograficamente, elemento a
+ * elemento (e, em caso de empate, pelo comprimento). Nos restantes casos são comparados os valores numéricos (`num_compare()`).
+ * 
+ * @param a Elemento.
+ * @param b Elemento.
+ * @return int Retorna um valor negativo, zero ou positivo, caso __a__ seja menor, igual ou maior que __b__.
+ */
+int compare(DADOS a, DADOS b)
+{
+    if (a.tipo == STRING && b.tipo == STRING)
+        return str_compare(a.dados, b.dados);
+
+    if (a.tipo == ARRAY && b.tipo == ARRAY)
+    {
+        STACK *x = a.dados;
+        STACK *y = b.dados;
+
+        for (int i = 1; i <= x->sp && i <= y->sp; i++)
+        {
+            int r = compare(array_get(x, i), array_get(y, i));
+            if (r != 0)
+                return r;
         }
+
+        return (x->sp > y->sp) - (x->sp < y->sp);
     }
+
+    return num_compare(a, b);
 }
@@ -2,8 +2,9 @@
  * @file expMat.c
  * @brief Operações matemáticas.
  * 
- * - __Nota:__ Todas as funções em expMat.c incluem uma libertação de memória (ex: `free(x.dados)`) uma vez que acedemos a um elemento da stack com
- * a função `pop()` para o qual foi alocada memória dinâmica que já não será usada.
+ * - __Nota:__ Os operandos numéricos são guardados diretamente nos elementos da stack (ex: `x.l` ou `x.n`), pelo que as operações aritméticas
+ * sobre LONG e DOUBLE não alocam nem libertam memória. Os inteiros (LONG) são operados como inteiros de 64 bits; quando o resultado não cabe num `long`, o
+ * overflow é detetado e o resultado passa a ser um BIGINT (ver bigint.c), que é operado com precisão arbitrária.
  */
 
 #include "stack.h"
@@ -11,6 +12,187 @@
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
+
+#define POTENCIA_MAX_BITS 1048576 ///< Tamanho máximo (em bits, cerca de 315 mil algarismos) de uma potência de inteiros exata; uma maior dá `inf` em `#`.
+
+// Aritmética de inteiros
+
+/**
+ * @brief Soma dois inteiros, detetando o overflow.
+ * 
+ * @param b Primeiro operando.
+ * @param a Segundo operando.
+ * @return DADOS Retorna a soma (LONG), ou um BIGINT caso esta não caiba num `long`.
+ */
+DADOS long_add(long b, long a)
+{
+    DADOS r, y, x;
+
+    r.tipo = y.tipo = x.tipo = LONG;
+    if (!__builtin_add_overflow(b, a, &r.l))
+        return r;
+
+    y.l = b;
+    x.l = a;
+    return big_add(y, x);
+}
+
+/**
+ * @brief Subtrai dois inteiros, detetando o overflow.
+ * 
+ * @param b Primeiro operando.
+ * @param a Segundo operando.
+ * @return DADOS Retorna a diferença (LONG), ou um BIGINT caso esta não caiba num `long`.
+ */
+DADOS long_sub(long b, long a)
+{
+    DADOS r, y, x;
+
+    r.tipo = y.tipo = x.tipo = LONG;
+    if (!__builtin_sub_overflow(b, a, &r.l))
+        return r;
+
+    y.l = b;
+    x.l = a;
+    return big_sub(y, x);
+}
+
+/**
+ * @brief Multiplica dois inteiros, detetando o overflow.
+ * 
+ * @param b Primeiro operando.
+ * @param a Segundo operando.
+ * @return DADOS Retorna o produto (LONG), ou um BIGINT caso este não caiba num `long`.
+ */
+DADOS long_mul(long b, long a)
+{
+    DADOS r, y, x;
+
+    r.tipo = y.tipo = x.tipo = LONG;
+    if (!__builtin_mul_overflow(b, a, &r.l))
+        return r;
+
+    y.l = b;
+    x.l = a;
+    return big_mul(y, x);
+}
+
+/**
+ * @brief Divide dois inteiros (com a divisão inteira de C, que trunca o resultado).
+ * 
+ * @param b Dividendo.
+ * @param a Divisor.
+ * @return DADOS Retorna o quociente (LONG), ou um BIGINT no único caso em que este não cabe num `long` (`LONG_MIN / -1`).
+ *         A divisão por zero dá o DOUBLE `b / 0.0` (`inf`, `-inf` ou `nan`), tal como a divisão de números não inteiros.
+ */
+DADOS long_div(long b, long a)
+{
+    DADOS r, y, x;
+
+    if (a == 0)
+    {
+        r.tipo = DOUBLE;
+        r.n = b / 0.0;
+        return r;
+    }
+
+    r.tipo = y.tipo = x.tipo = LONG;
+    if (a != -1 || b != LONG_MIN)
+    {
+        r.l = b / a;
+        return r;
+    }
+
+    y.l = b;
+    x.l = a;
+    return big_div(y, x);
+}
+
+/**
+ * @brief Calcula o resto da divisão de dois inteiros, com o sinal do dividendo (como o operador `%` de C).
+ * 
+ * @param b Dividendo.
+ * @param a Divisor.
+ * @return DADOS Retorna o resto (LONG). O resto da divisão por zero é o DOUBLE `fmod(b, 0.0)` (`nan`), em vez de terminar o programa, e
+ *         o de `LONG_MIN % -1` (que excede um `long` em C) é 0.
+ */
+DADOS long_mod(long b, long a)
+{
+    DADOS r;
+
+    if (a == 0)
+    {
+        r.tipo = DOUBLE;
+        r.n = fmod(b, 0.0);
+        return r;
+    }
+
+    r.tipo = LONG;
+    r.l = a == -1 ? 0 : b % a;
+    return r;
+}
+
+/**
+ * @brief Multiplica dois inteiros (LONG ou BIGINT), em inteiros de 64 bits sempre que ambos são LONG.
+ * 
+ * @param y Primeiro operando.
+ * @param x Segundo operando.
+ * @return DADOS Retorna o produto.
+ */
+static DADOS int_mul(DADOS y, DADOS x)
+{
+    return y.tipo == LONG && x.tipo == LONG ? long_mul(y.l, x.l) : big_mul(y, x);
+}
+
+/**
+ * @brief Eleva um inteiro (LONG ou BIGINT) a um expoente inteiro por exponenciação binária: a base é elevada ao quadrado sucessivamente e
+ * multiplicada no resultado para cada bit ativo do expoente, pelo que são feitas O(log e) multiplicações em vez de __e__.
+ * 
+ * As multiplicações são feitas em inteiros de 64 bits e o overflow é detetado (`long_mul()`), passando o resultado a BIGINT.
+ * 
+ * - __Nota:__ O resultado é exato (LONG ou BIGINT) sempre que tem no máximo `POTENCIA_MAX_BITS` bits; uma potência maior dá o DOUBLE de
+ * `pow()`, que é sempre `inf` ou `-inf`, já que o valor excede o maior DOUBLE. O tamanho de b^e está entre `(bits(b) - 1) * e + 1` e
+ * `bits(b) * e`: quando o primeiro já excede o limite a potência nem é calculada, o que evita que um expoente grande (por exemplo
+ * `2 1000000000 #`) esgote a memória e o tempo a construir um inteiro que nem poderia ser impresso; caso contrário a potência (com menos do
+ * dobro do limite) é calculada e o seu tamanho verificado. Para obter só os últimos algarismos de uma potência grande usa-se `e#`.
+ * 
+ * @param b Base.
+ * @param e Expoente (um expoente negativo dá 1).
+ * @return DADOS Retorna a potência.
+ */
+DADOS int_pow(DADOS b, long e)
+{
+    DADOS r, base = b;
+    long bits = big_bits(b), expoente = e, minimo;
+
+    r.tipo = LONG;
+    r.l = 1;
+
+    if (bits > 1 && (__builtin_mul_overflow(bits - 1, e, &minimo) || minimo >= POTENCIA_MAX_BITS))
+    {
+        r.tipo = DOUBLE;
+        r.n = pow(to_double(b), e);
+        return r;
+    }
+
+    while (e > 0)
+    {
+        if (e & 1)
+            r = int_mul(r, b);
+        e >>= 1;
+        if (e > 0)
+            b = int_mul(b, b);
+    }
+
+    if (big_bits(r) > POTENCIA_MAX_BITS)
+    {
+        r.tipo = DOUBLE;
+        r.n = pow(to_double(base), expoente);
+    }
+
+    return r;
+}
 
 /** 
  * @brief A função `s_add()` soma dois números inteiros contidos na stack.
@@ -39,6 +221,7 @@ void s_add(STACK *s)
                 case 'A': { add_arrays(s, x, y); return; }
                 case 'C': { add_char_array(s, x, y); return; }
                 case 'L': { add_num_array(s, x, y); return; }
+                case 'I': { add_num_array(s, x, y); return; }
                 case 'D': { add_num_array(s, x, y); return; }
             }
             return;
@@ -57,31 +240,34 @@ void s_add(STACK *s)
             switch (cy)
             {
                 case 'A': { add_num_array(s, x, y); return; }
-                case 'L':
-                {
-                    double *a = x.dados;
-                    double *b = y.dados;
+                case 'L': { push(s, long_add(y.l, x.l)); return; }
+                case 'I': { push(s, big_add(y, x)); return; }
 
-                    long ri = *b + *a;
-                    
-                    double r = ri;
-                    push_long(s, r);
+                default:
+                {
+                    double r = to_double(y) + x.l;
+                    push_double(s, r);
 
                     return;
                 }
+            }
+            return;
+        }
+        case 'I':
+        {
+            switch (cy)
+            {
+                case 'A': { add_num_array(s, x, y); return; }
+                case 'L': case 'I': { push(s, big_add(y, x)); return; }
 
                 default:
                 {
-                    double *a = x.dados;
-                    double *b = y.dados;
-
-                    double r = *b + *a;
+                    double r = to_double(y) + to_double(x);
                     push_double(s, r);
 
                     return;
                 }
             }
-            return;
         }
         case 'D':
         {
@@ -91,10 +277,7 @@ void s_add(STACK *s)
                 
                 default:
                 {
-                    double *a = x.dados;
-                    double *b = y.dados;
-
-                    double r = *b + *a;
+                    double r = to_double(y) + x.n;
                     push_double(s, r);
 
                     return;
@@ -126,24 +309,37 @@ void subtract(STACK *s)
     DADOS x = pop(s);
     DADOS y = pop(s);
     
-    double *a = x.dados;
-    double *b = y.dados;
+    double a = to_double(x);
+    double b = to_double(y);
 
     if (x.tipo == LONG && y.tipo == LONG)
-    {
-        long ri = *b - *a;
-        
-        double r = ri;
-        push_long(s, r);
-    }
+        push(s, long_sub(y.l, x.l));
+    else if (is_integer(x) && is_integer(y))
+        push(s, big_sub(y, x));
     else
     {
-        double r = *b - *a;
+        double r = b - a;
         push_double(s, r);
     }
-    
-    free(a);
-    free(b);
+}
+
+/**
+ * @brief Converte o número de repetições de um array ou de uma string num `long`. Um número negativo (ou `nan`) dá 0 repetições e um
+ * número maior do que qualquer `long` dá `LONG_MAX`, que é depois rejeitado por exceder o comprimento máximo do resultado.
+ * 
+ * @param x Número de repetições.
+ * @return long Retorna o número de repetições.
+ */
+static long repeat_count(DADOS x)
+{
+    if (x.tipo == BIGINT)
+        return ((INTEIRO *) x.dados)->neg ? 0 : LONG_MAX;
+    if (x.tipo != DOUBLE)
+        return to_long(x);
+    if (!(x.n > 0))
+        return 0;
+
+    return x.n < 0x1p63 ? (long) x.n : LONG_MAX;
 }
 
 /**
@@ -153,7 +349,8 @@ void subtract(STACK *s)
  * 
  * - __Nota:__ Caso o primeiro operando do input seja um ARRAY ou uma STRING, a função `multiply()` cria um novo array/string que contém 'n' cópias
  * do array/string original, onde 'n' é o valor do segundo operando. Por exemplo, o input `$ [ 1 2 3 ] 2 *` teria como resultado: `123123`, tal
- * como `$ "abc" 2 *` teria como resultado `abcabc`.
+ * como `$ "abc" 2 *` teria como resultado `abcabc`. A repetição de um array grande partilha os seus elementos (`array_repeat()`) e a de
+ * uma string é feita duplicando o resultado, com O(log n) cópias. Uma string com mais de `STR_MAX` caracteres é rejeitada (`check_str_length()`).
  * 
  * @param s Stack.
  * @param var Variáveis.
@@ -166,7 +363,7 @@ void multiply(STACK *s, DADOS *var)
     char cx = type_to_char(x);
     char cy = type_to_char(y);
 
-    double *a = x.dados;
+    double a = to_double(x);
 
     switch (cx)
     {
@@ -178,62 +375,42 @@ void multiply(STACK *s, DADOS *var)
             {
                 case 'A':
                 {
-                    long n = *a;
-                    STACK *array = y.dados;
-
-                    STACK *r = new_stack();
-
-                    int i, j, k;
-                    for (i=1; i <= n * array->sp; )
-                    {
-                        for (j=i, k=1; j < i + array->sp; j++, k++)
-                        {
-                            r->stack[j] = array->stack[k];
-                        }
-                        r->sp += array->sp;
-                        i = r->sp+1;
-                    }
-
-                    push_array(s, *r);
+                    push_array(s, array_repeat(y.dados, repeat_count(x)));
 
                     return;
                 }
                 case 'S':
                 {
-                    long n = *a;
-                    char *str = y.dados;
+                    long n = repeat_count(x);
+                    STR *str = y.dados;
+                    long total = 0;
 
-                    int tam = strlen(str) * n;
-                    char *r = malloc(sizeof(char) * tam);
+                    if (n > 0 && __builtin_mul_overflow(str->len, n, &total))
+                        total = LONG_MAX;
+                    check_str_length(total);
+                    STR *r = new_str_cap(total);
 
-                    int i, j, k;
-                    for (i=0; i < tam; )
-                    {
-                        int max = i + strlen(str);
-                        for (j=i, k=0; j < max; j++, k++)
-                            r[j] = str[k];
-                        i = j;
-                    }
-                    r[tam] = '\0';
+                    if (total > 0)
+                        str_append(r, str->str, str->len);
+                    while (r->len < total)          // Duplica o que já foi construído (no fim, copia apenas o que falta)
+                        str_append(r, r->str, r->len < total - r->len ? r->len : total - r->len);
 
+                    release(y);
                     push_string(s, r);
 
                     return;
                 }
                 default:
                 {
-                    double *b = y.dados;
+                    double b = to_double(y);
 
                     if (x.tipo == LONG && y.tipo == LONG)
-                    {
-                        long ri = *b * *a;
-                        
-                        double r = ri;
-                        push_long(s, r);
-                    }
+                        push(s, long_mul(y.l, x.l));
+                    else if (is_integer(x) && is_integer(y))
+                        push(s, big_mul(y, x));
                     else
                     {
-                        double r = *b * *a;
+                        double r = b * a;
                         push_double(s, r);
                     }
 
@@ -243,9 +420,6 @@ void multiply(STACK *s, DADOS *var)
             return;
         }
     }
-
-    free(x.dados);
-    free(y.dados);
 }
 
 /**
@@ -263,27 +437,18 @@ void divide(STACK *s)
 {   
     DADOS x = pop(s);
     DADOS y = pop(s);
-    
-    double *a = x.dados;
-    double *b = y.dados;
 
     if (x.tipo == LONG && y.tipo == LONG)
-    {
-        long ri = *b / *a;
-        
-        double r = ri;
-        push_long(s, r);
-    }
+        push(s, long_div(y.l, x.l));
+    else if (is_integer(x) && is_integer(y))
+        push(s, big_div(y, x));
     else if (x.tipo == STRING && y.tipo == STRING)
         slash_str(s, x, y);
     else
     {
-        double r = *b / *a;
+        double r = to_double(y) / to_double(x);
         push_double(s, r);
     }
-    
-    free(a);
-    free(b);
 }
 
 /**
@@ -296,16 +461,10 @@ void divide(STACK *s)
  */
 void bit_and(STACK *s)
 {
-    double *ai = pop(s).dados;
-    long a = *ai;
-    double *bi = pop(s).dados;
-    long b = *bi;
+    long a = to_long(pop(s));
+    long b = to_long(pop(s));
 
-    double r = b & a;
-    push_long(s, r);
-
-    free(ai);
-    free(bi);
+    push_long(s, b & a);
 }
 
 /**
@@ -318,16 +477,10 @@ void bit_and(STACK *s)
  */
 void bit_or(STACK *s)
 {
-    double *ai = pop(s).dados;
-    long a = *ai;
-    double *bi = pop(s).dados;
-    long b = *bi;
-    
-    double r = b | a;
-    push_long(s, r);
+    long a = to_long(pop(s));
+    long b = to_long(pop(s));
 
-    free(ai);
-    free(bi);
+    push_long(s, b | a);
 }
 
 /**
@@ -340,16 +493,10 @@ void bit_or(STACK *s)
  */
 void bit_xor(STACK *s)
 {
-    double *ai = pop(s).dados;
-    long a = *ai;
-    double *bi = pop(s).dados;
-    long b = *bi;
-    
-    double r = b ^ a;
-    push_long(s, r);
+    long a = to_long(pop(s));
+    long b = to_long(pop(s));
 
-    free(ai);
-    free(bi);
+    push_long(s, b ^ a);
 }
 
 /**
@@ -370,11 +517,11 @@ void bit_not(STACK *s, DADOS *var)
     
     if (x.tipo == ARRAY)      // Coloca na stack todos os elementos do ARRAY
     {
-        STACK *a = x.dados;
+        STACK *a = linearize(x.dados);
         
         for (int i=1; i <= a->sp; i++)
         {
-            DADOS r = a->stack[i];
+            DADOS r = array_get(a, i);
             push(s, r);
         }
     }
@@ -382,13 +529,9 @@ void bit_not(STACK *s, DADOS *var)
         execute_block(s, x, var);
     else                      // Operação NOT binária
     {
-        double *ai = x.dados;
-        long a = *ai;
+        long a = to_long(x);
         
-        double r = ~ a;
-        push_long(s, r);
-
-        free(x.dados);
+        push_long(s, ~a);
     }
 }
 
@@ -398,7 +541,9 @@ void bit_not(STACK *s, DADOS *var)
  * Para tal, é utilizada a função `pop()`, retirando da stack o elemento a ser trabalhado.
  * No final, após a subtração, o resultado obtido é colocado na stack através da função `push_long()` ou `push_double()`.
  * 
- * - __Nota:__ Para arrays ou strings, a função `decr()` retira o primeiro elemento do array ou string e coloca-o na stack.
+ * - __Nota:__ Para arrays ou strings, a função `decr()` retira o primeiro elemento do array ou string e coloca-o na stack. O resto do array
+ * é uma vista (`array_slice()`) e uma string que não é partilhada perde o primeiro caracter no próprio lugar (caso contrário, o resto é uma
+ * vista), pelo que nenhum elemento é copiado.
  * 
  * @param s Stack.
  */
@@ -408,37 +553,41 @@ void decr(STACK *s)
 
     if (x.tipo == LONG)
     {
-        push_long(s, (*(double*)x.dados) - 1);
+        push(s, long_sub(x.l, 1));
+    }
+    else if (x.tipo == BIGINT)
+    {
+        DADOS um;
+
+        um.tipo = LONG;
+        um.l = 1;
+        push(s, big_sub(x, um));
     }
     else if (x.tipo == CHAR)
     {
-        push_char(s, (*(char*)x.dados) - 1);
+        push_char(s, x.c - 1);
     }
     else if (x.tipo == ARRAY)
     {
         STACK *array = x.dados;
-        STACK *new_array = new_stack();
 
-        new_array->sp = array->sp-1;
-        for (int i=2, j=1; i <= array->sp; i++, j++)
-            new_array->stack[j] = array->stack[i];
-        
-        push_array(s, *new_array);
-        push(s, array->stack[1]);
-
-        free(array);
+        push_array(s, array_slice(array, 2, array->sp - 1));
+        push(s, array_get(array, 1));
     }
     else if (x.tipo == STRING)
     {
-        char *str = x.dados;
-        char elem = *str;
+        STR *str = x.dados;
+        char elem = str->len > 0 ? str->str[0] : '\0';
+
+        if (str->len > 0)
+            str = str_slice(&x, 1, str->len - 1);
 
-        push_string(s, ++str);
+        push_string(s, str);
         push_char(s, elem);
     }
     else
     {
-        push_double(s, (*(double*)x.dados) - 1);
+        push_double(s, x.n - 1);
     }
 }
 
@@ -448,7 +597,9 @@ void decr(STACK *s)
  * Para tal, é utilizada a função `pop()`, retirando da stack o elemento a ser trabalhado.
  * No final, após a adição, o resultado obtido é colocado na stack através da função `push_long()` ou `push_double()`.
  * 
- * - __Nota:__ Para arrays ou strings, a função `incr()` retira o último elemento do array ou string e coloca-o na stack.
+ * - __Nota:__ Para arrays ou strings, a função `incr()` retira o último elemento do array ou string e coloca-o na stack. O resto do array
+ * é uma vista (`array_slice()`) e uma string que não é partilhada perde o último caracter no próprio lugar (caso contrário, o resto da
+ * string é uma vista, `str_slice()`), pelo que nenhum elemento é copiado.
  * 
  * @param s Stack.
  */
@@ -457,37 +608,44 @@ void incr(STACK *s)
     DADOS x = pop(s);
     
     if (x.tipo == LONG)
-        push_long(s, (*(double*)x.dados) + 1);
+        push(s, long_add(x.l, 1));
+    else if (x.tipo == BIGINT)
+    {
+        DADOS um;
+
+        um.tipo = LONG;
+        um.l = 1;
+        push(s, big_add(x, um));
+    }
     else if (x.tipo == CHAR)
-        push_char(s, (*(char*)x.dados) + 1);
+        push_char(s, x.c + 1);
     else if (x.tipo == ARRAY)
     {
-        STACK* new_array = x.dados;
-        DADOS elem = new_array->stack[new_array->sp];
-        new_array->sp--;
-        
-        push_array(s, *new_array);
-        push(s, elem);
+        STACK *array = x.dados;
+
+        push_array(s, array_slice(array, 1, array->sp - 1));
+        push(s, array_get(array, array->sp));
     }
     else if (x.tipo == STRING)
     {
-        char *str = x.dados;
-        char elem;
-        int i;
-        for (i = 0; *(str+i) != '\0'; ++i);
-        elem = *(str+i-1);
-        *(str+i-1) = '\0';
+        STR *str = x.dados;
+        char elem = str->len > 0 ? str->str[str->len - 1] : '\0';
+
+        if (str->len > 0)
+            str = str_slice(&x, 0, str->len - 1);
+
         push_string(s, str);
         push_char(s, elem);
     }
     else
-        push_double(s, (*(double*)x.dados) + 1);
+        push_double(s, x.n + 1);
 }
 
 /**
  * @brief A função `mod()` dá-nos o módulo da divisão do segundo número da stack a contar do topo pelo que se encontra no topo.
  *        
- * Para esse fim usa `pop()` para obter os mesmos e `push()` para returnar o resultado da operação.
+ * Para esse fim usa `pop()` para obter os mesmos e `push()` para returnar o resultado da operação. O resto da divisão por zero é `nan`
+ * (ver `long_mod()`).
  * 
  * - __Nota:__ Quando o input é um bloco (BLOCK), realiza a operação de aplicar um bloco a um array/string, utilizando por isso
  * as funções `execute_block_array()` e `execute_block_string()`, cujo objetivo e funcionamento está documentado em stackBlocks.c.
@@ -504,25 +662,19 @@ void incr(STACK *s)
         execute_block_array(s, x, y, var);
     else if (x.tipo == BLOCK && y.tipo == STRING)
         execute_block_string(s, x, y, var);
+    else if (is_integer(x) && is_integer(y) && (x.tipo == BIGINT || y.tipo == BIGINT))
+        push(s, big_mod(y, x));
     else
     {
-        double *ai = x.dados;
-        long a = *ai;
-        double *bi = y.dados;
-        long b = *bi;
-
-        double r = b % a;
-        push_long(s, r);
-
-        free(x.dados);
-        free(y.dados);
+        push(s, long_mod(to_long(y), to_long(x)));
     }
 }
 
 /**
  * @brief Esta função tem como objetivo obter a exponenciação de valores da stack.
  *        
- * Este valor é obtido elevando o segundo número a contar de cima da stack por o do topo.
+ * Este valor é obtido elevando o segundo número a contar de cima da stack por o do topo. A potência de dois inteiros é exata até
+ * `POTENCIA_MAX_BITS` bits e `inf` acima desse tamanho (ver `int_pow()`).
  * 
  * - __Nota:__ Caso os inputs sejam strings, a função `exp()` efetua a operação de procura de substrings em strings, devolvendo o índice do primeiro caracter da substring encontrada.
  * 
@@ -533,67 +685,62 @@ void incr(STACK *s)
     DADOS x = pop(s);
     DADOS y = pop(s);
 
-    if (x.tipo == LONG && y.tipo == LONG)
+    if (x.tipo == LONG && is_integer(y))
     {
-        double r = 1;
-
-        double ai = *((double*)x.dados);
-        long a = ai;
-
-        double bi = *((double*)y.dados);
-        long b = bi;
-
-        while (a > 0)
-        {
-          r = r * b;
-          (a)--;
-        }
-        
-        push_long(s, r);
-
-        free(x.dados);
-        free(y.dados);
+        push(s, int_pow(y, x.l));
     }
     else if (x.tipo == STRING && y.tipo == STRING)
     {
-        char *a = x.dados;
-        char *b = y.dados;
-
-        if (strstr(b, a) == NULL)
-            push_long(s, -1);
-        else
-            push_long(s, strstr(b, a) - b);
+        STR *a = x.dados;
 
-        // free(x.dados);
-        // free(y.dados);
+        push_long(s, str_find(y.dados, a->str, a->len, 0));
     }
     else if (x.tipo == CHAR && y.tipo == STRING)
     {
-        char *ai = x.dados;
-        char *a = malloc(sizeof(char)+1);
-        
-        a[0] = *ai;
-        a[1] = '\0';
-
-        char *b = y.dados;
-
-        if (strstr(b, a) == NULL)
-            push_long(s, -1);
-        else
-            push_long(s, strstr(b, a) - b);
-
-        // free(x.dados);
-        // free(y.dados);
+        push_long(s, str_find(y.dados, &x.c, 1, 0));
     }
     else
     {
-        double a = *((double*)x.dados);
-        double b = *((double*)y.dados);
+        double a = to_double(x);
+        double b = to_double(y);
 
         double r = pow(b, a);
         push_double(s, r);
+    }
+}
+
+/**
+ * @brief Potência modular (operador `e#`): retira da stack a base __b__, o expoente __e__ e o módulo __m__ (no topo) e coloca
+ * __b__^__e__ % __m__, com o mesmo resultado que `b e # m %`.
+ *
+ * A potência é calculada por exponenciação binária com cada produto reduzido módulo __m__ (`big_mod_pow()`), pelo que nunca é calculada
+ * por inteiro e os valores intermédios não excedem m^2. Os operandos que não são inteiros são convertidos com `to_long()`, tal como em `%`.
+ * Caso __m__ seja 0, o resultado é o da potência (`#`), sem redução.
+ *
+ * @param s Stack.
+ */
+void mod_pow(STACK *s)
+{
+    DADOS m = pop(s);
+    DADOS x = pop(s);
+    DADOS y = pop(s);
+    DADOS *op[3] = {&y, &x, &m};
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (!is_integer(*op[i]))
+        {
+            op[i]->l = to_long(*op[i]);
+            op[i]->tipo = LONG;
+        }
+    }
 
-        free(x.dados);
-        free(y.dados);
+    if (m.tipo == LONG && m.l == 0)
+    {
+        push(s, y);
+        push(s, x);
+        expo(s);
     }
+    else
+        push(s, big_mod_pow(y, x, m));
 }
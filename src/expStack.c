@@ -2,8 +2,8 @@
  * @file expStack.c
  * @brief Operações de manipulação da stack.
  * 
- * - __Nota:__ Todas as funções em expStack.c incluem uma libertação de memória (`free(d.dados)`) uma vez que acedemos a um elemento da stack com
- * a função `pop()` para o qual foi alocada memória dinâmica que já não será usada.
+ * - __Nota:__ Como os números e os caracteres são guardados diretamente nos elementos da stack, duplicar, rodar ou trocar elementos
+ * não aloca memória.
  */
 
 #include "stack.h"
@@ -25,33 +25,34 @@ void dup (STACK *s)
 }
 
 /**
- * @brief Roda os primeiros três elementos da stack, introduzindo-os na mesma pela ordem pretendida com função `push()`.
+ * @brief Roda os primeiros três elementos da stack, trocando-os de posição diretamente no array da stack.
+ * 
+ * - __Nota:__ Os elementos são apenas movidos, pelo que a contagem de referências das strings não é alterada.
  * 
  * @param s Stack.
  */
 void spin (STACK *s)
 {
-    DADOS x = pop(s);
-    DADOS y = pop(s);
-    DADOS z = pop(s);
+    DADOS z = s->stack[s->sp - 2];
 
-    push(s, y);
-    push(s, x);
-    push(s, z);
+    s->stack[s->sp - 2] = s->stack[s->sp - 1];
+    s->stack[s->sp - 1] = s->stack[s->sp];
+    s->stack[s->sp] = z;
 }
 
 /**
- * @brief Troca os dois primeiros elementos da stack, introduzindo-os na mesma por ordem oposta com função `push()`.
+ * @brief Troca os dois primeiros elementos da stack diretamente no array da stack.
+ * 
+ * - __Nota:__ Os elementos são apenas movidos, pelo que a contagem de referências das strings não é alterada.
  * 
  * @param s Stack.
  */
 void swap(STACK *s) 
 {
-    DADOS x = pop (s);
-    DADOS y = pop (s);
+    DADOS x = s->stack[s->sp];
 
-    push(s, x);
-    push(s, y);
+    s->stack[s->sp] = s->stack[s->sp - 1];
+    s->stack[s->sp - 1] = x;
 }
 
 /**
@@ -69,13 +70,11 @@ void ncopy(STACK *s, DADOS *var)
     if (t.tipo == BLOCK)
     {
         DADOS f = pop(s);
-        if (strcmp((char*)t.dados, "") != 0 || strcmp((char*)t.dados, " ") != 0)
-            sort(s, f, t, var);
+        sort(s, f, t, var);
     }
     else
     {
-        double *ii = (double*)t.dados;
-        long i = *ii;
+        long i = to_long(t);
         
         DADOS y = s->stack[(s->sp) - i];
 
@@ -5,53 +5,98 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include "stack.h"
 
-// Colocação de elementos na stack
+#define LINHA_INICIAL 256 ///< Capacidade inicial da string onde é lida uma linha do input.
+#define LEITURA_INICIAL 65536 ///< Capacidade inicial da string onde é lido o input com `t`.
+
+// Interpretação de operandos
 
 /**
- * @brief Esta função está encarregue de adicionar à stack os elementos do input.
+ * @brief Esta função está encarregue de interpretar os operandos numéricos do input.
  * 
  * Para isso, a função:
  * 1. Verifica o tipo do elemento introduzido pelo utilizador;
- * 2. Introduz o elemento na stack utilizando a função de push respetiva.
+ * 2. Cria o elemento com o tipo respetivo, que é depois guardado como literal no programa compilado.
  * 
- * @param s Stack.
- * @param token String que contém o input do programa.
+ * Um inteiro escrito só com algarismos é lido exatamente: com `parse_long()` caso tenha no máximo 18 algarismos (e caiba por isso sempre
+ * num `long`), ou com `big_parse()` caso contrário, que devolve um BIGINT quando o valor não cabe num `long`. Os restantes números são
+ * lidos diretamente do texto do programa com `parse_double()`, sem copiar o token (a leitura pára no primeiro caracter que não faz parte
+ * do número); um número sem '.' (em notação científica, como `1e5`) é um LONG caso caiba num `long`.
+ * 
+ * @param token Operando (não terminado em '\0').
+ * @param len Comprimento do operando.
+ * @return DADOS Retorna o operando interpretado.
  */
-void val(STACK* s, char* token)
+DADOS val(const char* token, int len)
 {
-    int i, n = strlen(token);
+    DADOS d;
+    int i = *token == '-';
+
+    while (i < len && token[i] >= '0' && token[i] <= '9')
+        i++;
 
-    if (token[0] == '"')                // Caso em que o operando é STRING (o input encontra-se entre aspas)
+    if (i == len && len > (*token == '-'))
     {
-       char string[n-1];
-       int j=0;
-       for (i=1; token[i] != '"'; i++, j++)
-       {
-           string[j] = token[i];
-       }
-       push_string(s, string);
+        if (len - (*token == '-') <= 18)
+        {
+            d.tipo = LONG;                  // Caso em que o operando é um inteiro que cabe sempre num `long`
+            d.l = parse_long(token, len);
+        }
+        else
+            d = big_parse(token, len);      // Caso em que o operando é um inteiro que pode não caber num `long` (LONG ou BIGINT)
+
+        return d;
     }
-    else
+
+    d.tipo = DOUBLE;
+    d.n = parse_double(token, len);
+
+    if (memchr(token, '.', len) == NULL && d.n >= -9223372036854775808.0 && d.n < 9223372036854775808.0)
+    {
+        long l = parse_long(token, len);    // Caso em que o operando é LONG (o input não contém um '.')
+
+        d.tipo = LONG;
+        d.l = (double) l == d.n ? l : (long) d.n;
+    }
+
+    return d;
+}
+
+// Funções de input/output (operadores 'l', 't' e 'p')
+
+/**
+ * @brief Lê uma linha do input, de qualquer comprimento, sem o '\n' final.
+ * 
+ * A linha é lida em blocos diretamente para o fim da string, cuja capacidade duplica sempre que fica cheia, pelo que cada caracter só é
+ * copiado uma vez do buffer do input (e o custo de ler uma linha é linear no seu comprimento).
+ * 
+ * @return STR* Retorna a linha lida, ou NULL caso o input já tenha terminado.
+ */
+STR* read_line()
+{
+    STR* r = new_str_cap(LINHA_INICIAL);
+    int lida = 0;
+
+    while (fgets(r->str + r->len, r->cap - r->len + 1, stdin) != NULL)
     {
-        for (i=0; token[i] != '\0' && token[i] != '.'; i++);
-        if (i != n)                    // Caso em que o operando é DOUBLE (o input contém um '.')
+        lida = 1;
+        r->len += strlen(r->str + r->len);
+        if (r->len > 0 && r->str[r->len - 1] == '\n')
         {
-            double d;
-            sscanf(token, "%lf", &d);
-            push_double(s, d);
+            r->str[--r->len] = '\0';
+            break;
         }
-        else                           // Caso em que o operando é LONG (o input é apenas constituído por números)
+        if (r->len == r->cap)
         {
-            double num;
-            sscanf(token, "%lf", &num);
-            push_long(s, num);
+            r->str = arena_realloc(r->str, r->cap + 1, 2 * r->cap + 1);
+            r->cap *= 2;
         }
     }
-}
 
-// Funções de input/output (operadores 'l', 't' e 'p')
+    return lida ? r : NULL;
+}
 
 /**
  * @brief Esta função representa a ação do comando `l`, que recebe uma nova linha de input por cada ocorrência do comando.
@@ -60,263 +105,293 @@ void val(STACK* s, char* token)
  */
 void new_line (STACK *s)
 {
-    char* line = malloc(sizeof(char) * 10002);
-    if (fgets (line, 10002, stdin) != NULL)
-    {
-        line[strlen(line)-1] = '\0';
+    STR* line = read_line();
+    if (line != NULL)
         push_string (s,line);
-    }
 }
 
 /**
- * @brief Esta função representa a ação do comando `t`, que recebe uma quantidade de linhas de input por cada ocorrência do comando.
+ * @brief Esta função representa a ação do comando `t`, que recebe todo o input que falta ler, como uma única string.
+ * 
+ * O input é lido em blocos diretamente para o fim da string, cuja capacidade duplica sempre que fica cheia, pelo que o custo é linear
+ * no tamanho do input (que não tem limite, tal como o comprimento de cada linha, e pode conter qualquer caracter).
  * 
  * @param s Stack.
  */
 void all_lines (STACK *s)
 {
-    char* line = malloc(sizeof(char) * 10002);
-    char* line2 = malloc(sizeof(char) * 10002);
-    while (fgets (line2,10002,stdin) != NULL)
+    STR* r = new_str_cap(LEITURA_INICIAL);
+    size_t n;
+
+    while ((n = fread(r->str + r->len, 1, r->cap - r->len, stdin)) > 0)
     {
-        strcat(line , line2);
+        r->len += n;
+        if (r->len == r->cap)
+        {
+            r->str = arena_realloc(r->str, r->cap + 1, 2 * r->cap + 1);
+            r->cap *= 2;
+        }
     }
-    push_string (s,line);
+    r->str[r->len] = '\0';
+
+    push_string (s,r);
 }
 
-// Handling de inputs
+// Impressão da stack
+
+#define SAIDA_TAM 65536 ///< Capacidade do buffer de saída.
+
+static char saida[SAIDA_TAM]; ///< Buffer de saída, escrito no `stdout` de uma só vez quando fica cheio e no fim da impressão.
+static int saida_len = 0; ///< Número de caracteres guardados no buffer de saída.
 
 /**
- * @brief Função auxiliar que verifica se um caracter é uma letra maiúscula, ou seja, uma variável.
- * 
- * @param c Carcater a ser verificado.
- * @return int Retorna 1 (True) ou 0 (False).
+ * @brief Escreve o conteúdo do buffer de saída no `stdout`.
  */
-int isVar(char c)
+static void out_flush()
 {
-    if (c >= 'A' && c <= 'Z')
-        return 1;
-    else
-        return 0;
+    fwrite(saida, 1, saida_len, stdout);
+    saida_len = 0;
 }
 
 /**
- * @brief Lida com o input de variáveis, determinando se devemos guardar um elemento na variável ou introduzir na stack o seu conteúdo.
- * 
- * Para isso, a função:
- * 1. Verifica se o input contém `:X`, ou seja, se queremos guardar o topo da stack na variável X, sendo X uma variável qualquer de A a Z;
- * 2. Caso contrário, o input é apenas uma variável pelo que introduzimos na stack o seu conteúdo.
- * 
- * - __Nota:__ A função recebe o array `var` como argumento, que é responsável por armazenar as variáveis.
- * Este array é declarado e inicializado na função `main()`.
- * 
- * @param s Stack.
- * @param token String que contém o input do programa.
- * @param var Array que armazena as variáveis.
+ * @brief Acrescenta __n__ caracteres ao buffer de saída (os textos maiores do que o buffer são escritos diretamente).
+ *
+ * @param b Caracteres.
+ * @param n Número de caracteres.
  */
-void handle_variables(STACK* s, char* token, DADOS *var)
-{   
-    if (token[0] == ':')
-    {
-        DADOS d = pop(s);        
-        int n = token[1];
-        
-        var[n-65] = d;
-        push(s, d);
-    }
-    else
+static void out_write(const char *b, long n)
+{
+    if (saida_len + n > SAIDA_TAM)
+        out_flush();
+    if (n > SAIDA_TAM)
     {
-        char n = token[0];
-        if (n >= 'A' && n <= 'Z')
-            push(s, var[n-65]);
+        fwrite(b, 1, n, stdout);
+        return;
     }
+
+    memcpy(saida + saida_len, b, n);
+    saida_len += n;
 }
 
 /**
- * @brief Lida com os inputs do programa, determinando que função deve ser utilizada para lidar com cada um deles.
- * 
- * Para isso, a função:
- * 1. Verifica se o input é um operador ou uma variável, executando a função correspondente se o mesmo se verificar;
- * 2. Caso contrário, chama a próxima função handle_token.
- * 
- * @param s Stack.
- * @param token String que contém o input do programa.
- * @param var Array que armazena as variáveis.
+ * @brief Escreve um inteiro em base 10, com o mesmo resultado que `printf("%ld")`.
+ *
+ * @param v Inteiro.
+ * @param b Buffer onde é escrito o resultado (com pelo menos 24 caracteres).
+ * @return int Retorna o número de caracteres escritos.
  */
-void handle_token(STACK* s, char* token, DADOS *var)
+int format_long(long v, char *b)
 {
-    switch (token[0])
+    char t[24];
+    char *p = t + sizeof(t);
+    unsigned long u = v < 0 ? 0 - (unsigned long) v : (unsigned long) v;
+
+    do
     {
-        // Expressões matemáticas
-
-        case '+': { s_add(s); return; }          // Também opera com arrays/strings
-        case '*': { multiply(s, var); return; }  // Também opera com arrays/strings e blocos
-        case '/': { divide(s); return; }
-        case '(': { decr(s); return; }           // Também opera com arrays/strings
-        case ')': { incr(s); return; }           // Também opera com arrays/strings
-        case '%': { mod(s, var); return; }       // Também opera com blocos
-        case '#': { expo(s); return; }           // Também opera com arrays/strings
-        case '&': { bit_and(s); return; }
-        case '|': { bit_or(s); return; }
-        case '^': { bit_xor(s); return; }
-        case '~': { bit_not(s, var); return; }   // Também opera com arrays/blocos
-
-        default: { handle_token2(s, token, var); return; }
-    }
+        *--p = '0' + u % 10;
+        u /= 10;
+    } while (u != 0);
+
+    if (v < 0)
+        *--p = '-';
+
+    memcpy(b, p, t + sizeof(t) - p);
+    return t + sizeof(t) - p;
 }
 
 /**
- * @brief 2ª função da cadeia handle_token. Lida com os inputs do programa, determinando que função deve ser utilizada para lidar com cada um deles.
- * 
- * Para isso, a função:
- * 1. Verifica se o input é um operador ou uma variável, executando a função correspondente se o mesmo se verificar;
- * 2. Caso contrário, chama a próxima função handle_token.
- * 
- * @param s Stack.
- * @param token String que contém o input do programa.
- * @param var Array que armazena as variáveis.
+ * @brief Acrescenta um inteiro ao buffer de saída, com o mesmo resultado que `printf("%ld")`.
+ *
+ * @param v Inteiro.
  */
+static void out_long(long v)
+{
+    char b[24];
+
+    out_write(b, format_long(v, b));
+}
 
-void handle_token2(STACK* s, char* token, DADOS *var)
+/**
+ * @brief Multiplica um número por 10^__p__, com uma única operação corretamente arredondada.
+ *
+ * @param a Número.
+ * @param p Expoente (entre -22 e 22, para que a potência de 10 seja exata).
+ * @return double Retorna o resultado.
+ */
+static double scale10(double a, int p)
 {
-    switch (token[0])
+    static const double potencia10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    return p >= 0 ? a * potencia10[p] : a / potencia10[-p];
+}
+
+/**
+ * @brief Escreve um número em vírgula flutuante com o mesmo resultado que `printf("%g")` (6 algarismos significativos, sem zeros à
+ * direita, em notação científica caso o expoente seja menor que -4 ou maior que 5).
+ *
+ * Os 6 algarismos são obtidos com uma única multiplicação ou divisão por uma potência de 10 exata. Como o erro desta operação é muito
+ * inferior a 10^-6 unidades do último algarismo, o arredondamento só pode ser diferente do de `printf()` quando o valor está quase a meio
+ * de dois resultados possíveis; nesse caso (tal como para os expoentes muito grandes ou pequenos, o zero, `inf` e `nan`) o número é
+ * formatado por `snprintf()`.
+ *
+ * @param x Número.
+ * @param b Buffer onde é escrito o resultado (com pelo menos 32 caracteres).
+ * @return int Retorna o número de caracteres escritos.
+ */
+int format_g(double x, char *b)
+{
+    double a = fabs(x);
+
+    if (!(a > 0) || a > 1e27 || a < 1e-17)
+        return snprintf(b, 32, "%g", x);
+
+    int e = (int) floor(log10(a));
+    double y = scale10(a, 5 - e);
+
+    if (y < 100000 || y >= 1000000)
     {
-        // Input/Output
+        e += y < 100000 ? -1 : 1;
+        if (5 - e > 22 || 5 - e < -22)
+            return snprintf(b, 32, "%g", x);
+        y = scale10(a, 5 - e);
+    }
+
+    double r = floor(y);
+
+    if (fabs(y - r - 0.5) < 1e-6)
+        return snprintf(b, 32, "%g", x);
 
-        case 'l': { new_line(s); return;}
-        case 't': { all_lines(s); return;}
+    long m = (long) r + (y - r > 0.5);
 
-        // Blocks
+    if (m == 1000000)
+    {
+        m = 100000;
+        e++;
+    }
 
-        case 'w': {truthy (s,var); return; }
+    char d[6];
+    int nd = 6;
+    char *p = b;
 
-        // Conversões
+    for (int i = 5; i >= 0; i--, m /= 10)
+        d[i] = '0' + m % 10;
+    while (nd > 1 && d[nd - 1] == '0')
+        nd--;
 
-        case 'i': { conv_int(s); return; }
-        case 'f': { conv_double(s); return; }
-        case 'c': { conv_char(s); return; }
-        case 's': { conv_string(s); return; }
+    if (x < 0)
+        *p++ = '-';
 
-        default: { handle_token3(s, token, var); return; }
+    if (e < -4 || e > 5)
+    {
+        *p++ = d[0];
+        if (nd > 1)
+            *p++ = '.';
+        for (int i = 1; i < nd; i++)
+            *p++ = d[i];
+        *p++ = 'e';
+        *p++ = e < 0 ? '-' : '+';
+        e = abs(e);
+        if (e >= 100)
+            *p++ = '0' + e / 100;
+        *p++ = '0' + e / 10 % 10;
+        *p++ = '0' + e % 10;
+    }
+    else if (e >= 0)
+    {
+        for (int i = 0; i <= e; i++)
+            *p++ = d[i];
+        if (nd > e + 1)
+            *p++ = '.';
+        for (int i = e + 1; i < nd; i++)
+            *p++ = d[i];
     }
+    else
+    {
+        *p++ = '0';
+        *p++ = '.';
+        for (int i = -1; i > e; i--)
+            *p++ = '0';
+        for (int i = 0; i < nd; i++)
+            *p++ = d[i];
+    }
+
+    return p - b;
 }
 
 /**
- * @brief 3ª função da cadeia handle_token. Lida com os inputs do programa, determinando que função deve ser utilizada para lidar com cada um deles.
- * 
- * Para isso, a função:
- * 1. Verifica se o input é um operador ou uma variável, executando a função correspondente se o mesmo se verificar;
- * 2. Caso contrário, chama a próxima função handle_token.
- * 
- * @param s Stack.
- * @param token String que contém o input do programa.
- * @param var Array que armazena as variáveis.
+ * @brief Acrescenta um número em vírgula flutuante ao buffer de saída, no formato de `printf("%g")`.
+ *
+ * @param x Número.
  */
+static void out_double(double x)
+{
+    char b[32];
 
+    out_write(b, format_g(x, b));
+}
 
-void handle_token3(STACK* s, char* token, DADOS *var)
+/**
+ * @brief Acrescenta um elemento que não é um array ao buffer de saída, de acordo com o seu tipo.
+ *
+ * @param d Elemento.
+ */
+static void out_value(DADOS d)
 {
-    switch (token[0])
-    {
-        // Stack
-
-        case '_': { dup(s); return; }
-        case ';': { pop(s); return; }
-        case '\\': { swap(s); return; }
-        case '@': { spin(s); return; }
-        case '$': { ncopy(s, var); return; }
-
-        // Lógica
-
-        case '=': { equal(s); return; }          // Também opera com arrays/strings
-        case '<': { is_smaller(s); return; }     // Também opera com arrays/strings
-        case '>': { is_bigger(s); return; }      // Também opera com arrays/strings
-        case '!': { lnot(s); return; }
-        case '?': { if_else(s); return; }
-        case 'e':
-        {
-            switch (token[1])
-            {
-                case '&': { and(s); return; }
-                case '|': { or(s); return; }
-                case '<': { smaller(s); return; }
-                case '>': { bigger(s); return; }
-            }
-            return;
-        }
+    char c;
 
-        default: { handle_token4(s, token, var); return; }
+    if (d.tipo == LONG)           // Caso em que o elemento da stack é um LONG
+        out_long(d.l);
+    else if (d.tipo == BIGINT)    // Caso em que o elemento da stack é um BIGINT
+    {
+        STR *str = big_to_str(d.dados);
+        out_write(str->str, str->len);
+    }
+    else if (d.tipo == DOUBLE)    // Caso em que o elemento da stack é um DOUBLE
+        out_double(d.n);
+    else if (d.tipo == CHAR)      // Caso em que o elemento da stack é um CHAR
+    {
+        c = d.c;
+        out_write(&c, 1);
+    }
+    else if (d.tipo == STRING)    // Caso em que o elemento da stack é uma STRING
+        out_write(((STR*)d.dados)->str, ((STR*)d.dados)->len);
+    else if (d.tipo == BLOCK)     // Caso em que o elemento da stack é um BLOCK
+    {
+        out_write("{ ", 2);
+        out_write(((BLOCO*)d.dados)->texto, ((BLOCO*)d.dados)->len);
+        out_write("}", 1);
     }
 }
 
 /**
- * @brief 4ª e última função da cadeia handle_token. Lida com os inputs do programa, determinando que função deve ser utilizada para lidar com cada um deles.
- * 
- * Para isso, a função:
- * 1. Verifica se o input é um operador ou uma variável, executando a função correspondente se o mesmo se verificar;
- * 2. Caso contrário, o input será um operando e é introduzido na stack com a função `val()`.
- * 
- * @param s Stack.
- * @param token String que contém o input do programa.
- * @param var Array que armazena as variáveis.
+ * @brief Acrescenta ao buffer de saída todos os valores de um array compacto (apenas LONG ou apenas DOUBLE) ou de um intervalo.
+ *
+ * @param a Array.
  */
-
-void handle_token4(STACK* s, char* token, DADOS *var)
+static void out_compact(STACK *a)
 {
-    switch (token[0])
-    {
-        // Arrays e Strings
-
-        case '[': { create_array(s, token, var); return; }
-        case '"': { create_string(s, token); return;}
-        case '{': { create_block(s, token); return; }
-        case ',': { range(s, var); return; }     // Também opera com blocos
-        case 'N':
-        {
-            switch (token[1])
-            {
-                case '/': { div_newline(s); return; }
-                case '\0': { handle_variables(s, token, var); return; } 
-            }
-            return;
-        }
-        case 'S':
-        {
-            switch (token[1])
-            {
-                case '/': { div_whitespace(s); return; }
-                case '\0': { handle_variables(s, token, var); return; }
-            }
-            return;
-        }
-        
-        // Casos especiais
-
-        case 0: { return; }
-
-        default:
-        { 
-            // Expressões matemáticas
-            
-            if (strlen(token) == 1 && token[0] == '-')
-                subtract(s);
-
-            // Variáveis
-
-            else if (token[0] == ':' || isVar(token[0]))
-                handle_variables(s, token, var);
-            
-            // Operandos
-
-            else
-                val(s, token);
-            
-            return;
-        }
-    }
+    if (a->formato == LONGS)
+        for (long i = 1; i <= a->sp; ++i)
+            out_long(a->longs[i]);
+    else if (a->formato == DOUBLES)
+        for (long i = 1; i <= a->sp; ++i)
+            out_double(a->doubles[i]);
+    else
+        for (long i = 0; i < a->sp; ++i)
+            out_long(a->inicio + i * a->passo);
 }
 
-// Impressão da stack
+/**
+ * @brief Array cuja impressão está a decorrer, com a posição do último elemento impresso ("__NIVEL__").
+ */
+typedef struct
+{
+    STACK *a; ///< Array.
+    long i; ///< Último elemento impresso.
+} NIVEL;
 
 /**
  * @brief Esta função imprime o conteúdo da stack.
@@ -325,31 +400,60 @@ void handle_token4(STACK* s, char* token, DADOS *var)
  * 1. Percorre o array de dados da stack, desde a primeira posição até à posição atual do "stack pointer" (`s->sp`);
  * 2. Imprime o conteúdo de cada elemento, de acordo com o seu tipo.
  * 
+ * Os arrays compactos (apenas LONG ou apenas DOUBLE) e os intervalos são impressos diretamente a partir dos seus valores e as árvores
+ * parte a parte. Os arrays encaixados são percorridos com uma pilha explícita (em vez de recursivamente) e o resultado é acumulado num
+ * buffer, escrito no `stdout` em blocos de `SAIDA_TAM` caracteres, em vez de uma chamada a `printf()` por elemento.
+ * 
  * @param s Stack.
  */
 void print_stack(STACK *s)
 {
-    DADOS d;
-    for (int i = 1; i <= s->sp; ++i)
+    int cap = STACK_INICIAL, n = 1;
+    NIVEL *pilha = arena_alloc(sizeof(NIVEL) * cap);
+
+    pilha[0].a = s;
+    pilha[0].i = 0;
+
+    while (n > 0)
     {
-        d = s->stack[i];
-        if (d.tipo == LONG)           // Caso em que o elemento da stack é um LONG
+        STACK *a = pilha[n - 1].a;
+
+        if (n + 1 >= cap)
+        {
+            pilha = arena_realloc(pilha, sizeof(NIVEL) * cap, sizeof(NIVEL) * 2 * cap);
+            cap *= 2;
+        }
+
+        if (a->formato == ARVORE)
         {
-            double *ri = d.dados;
-            long r = *ri;
-            printf("%ld", r);
+            pilha[n - 1].a = a->dir;
+            pilha[n].a = a->esq;
+            pilha[n - 1].i = pilha[n].i = 0;
+            n++;
+        }
+        else if (a->formato != GENERICO)
+        {
+            out_compact(a);
+            n--;
+        }
+        else if (pilha[n - 1].i >= a->sp)
+            n--;
+        else
+        {
+            DADOS d = a->stack[++pilha[n - 1].i];
+
+            if (d.tipo == ARRAY)
+            {
+                pilha[n].a = d.dados;
+                pilha[n].i = 0;
+                n++;
+            }
+            else
+                out_value(d);
         }
-        else if (d.tipo == DOUBLE)    // Caso em que o elemento da stack é um DOUBLE
-            printf("%g", *((double*)d.dados));
-        else if (d.tipo == CHAR)      // Caso em que o elemento da stack é um CHAR
-            printf("%c", *((char*)d.dados));
-        else if (d.tipo == STRING)    // Caso em que o elemento da stack é uma STRING
-            printf("%s", (char*)d.dados);
-        else if (d.tipo == ARRAY)     // Caso em que o elemento da stack é um ARRAY
-            print_stack(d.dados);
-        else if (d.tipo == BLOCK)     // Caso em que o elemento da stack é um BLOCK
-            printf("{ %s}", (char*)d.dados);
     }
+
+    out_flush();
 }
 
 // Funções auxiliares
@@ -367,6 +471,7 @@ char type_to_char(DADOS x)
     if (x.tipo == ARRAY) cx = 'A';
     else if (x.tipo == STRING) cx = 'S';
     else if (x.tipo == LONG) cx = 'L';
+    else if (x.tipo == BIGINT) cx = 'I';
     else if (x.tipo == CHAR) cx = 'C';
     else if (x.tipo == BLOCK) cx = 'B';
     else cx = 'D';
@@ -0,0 +1,393 @@
+/**
+ * @file kernels.c
+ * @brief Execução direta dos blocos mais comuns (um operador, ou um literal/`_` seguido de um operador) sobre cada elemento.
+ *
+ * Os blocos como `{ 1 + }`, `{ 2 * }`, `{ _ * }`, `{ 2 % }`, `{ 0 > }` ou `{ i }` são reconhecidos a partir do seu programa compilado e
+ * aplicados a cada elemento por uma função em C, sem colocar o elemento numa stack nem despachar as instruções. O resultado de cada
+ * operação é exatamente o mesmo que o do operador correspondente.
+ */
+
+#include "stack.h"
+#include <math.h>
+
+/**
+ * @brief Reconhece os blocos que podem ser executados por um kernel: `{ op }` (operador unário), `{ literal op }` e `{ _ op }`
+ * (operador binário cujo segundo operando é o literal ou o próprio elemento).
+ *
+ * @param p Programa do bloco.
+ * @param k Endereço onde é guardada a descrição do kernel.
+ * @return int Retorna 1 caso o bloco tenha um kernel, ou 0 caso contrário.
+ */
+int block_kernel(PROGRAMA* p, KERNEL* k)
+{
+    if (p->n == 1)
+    {
+        switch (p->instr[0].op)
+        {
+            case OP_INT: case OP_DOUBLE: case OP_CHAR: case OP_STRING: case OP_DECR: case OP_INCR: case OP_LNOT: case OP_BNOT:
+                k->op = p->instr[0].op;
+                k->forma = KERNEL_UNARIO;
+                k->lit.tipo = LONG;
+                k->lit.l = 0;
+                return 1;
+            default:
+                return 0;
+        }
+    }
+
+    if (p->n != 2 || (p->instr[0].op != OP_LIT && p->instr[0].op != OP_DUP))
+        return 0;
+    if (p->instr[0].op == OP_LIT && p->instr[0].lit.tipo == BIGINT)
+        return 0;
+
+    switch (p->instr[1].op)
+    {
+        case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_MOD: case OP_EXPO:
+        case OP_BAND: case OP_BOR: case OP_BXOR:
+        case OP_EQUAL: case OP_SMALLER: case OP_BIGGER: case OP_MIN: case OP_MAX: case OP_AND: case OP_OR:
+            k->op = p->instr[1].op;
+            k->forma = p->instr[0].op == OP_LIT ? KERNEL_LITERAL : KERNEL_DUP;
+            k->lit = p->instr[0].lit;
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Aplica um kernel unário a um elemento.
+ *
+ * @param op Operação.
+ * @param y Elemento.
+ * @return DADOS Retorna o resultado.
+ */
+DADOS kernel_unary(OPCODE op, DADOS y)
+{
+    DADOS r;
+    r.tipo = LONG;
+
+    switch (op)
+    {
+        case OP_INT: { r.l = to_long(y); return r; }
+        case OP_DOUBLE: { r.tipo = DOUBLE; r.n = to_double(y); return r; }
+        case OP_STRING: { r.tipo = STRING; r.dados = number_to_str(y); return r; }
+        case OP_CHAR:
+        {
+            r.tipo = CHAR;
+            if (y.tipo == LONG)
+                r.c = y.l;
+            else if (y.tipo == DOUBLE)
+                r.c = y.n;
+            else
+                r.c = y.c;
+            return r;
+        }
+        case OP_DECR:
+        case OP_INCR:
+        {
+            int d = op == OP_INCR ? 1 : -1;
+            if (y.tipo == CHAR)
+            {
+                r.tipo = CHAR;
+                r.c = y.c + d;
+            }
+            else if (y.tipo == LONG)
+                r = long_add(y.l, d);
+            else
+            {
+                r.tipo = DOUBLE;
+                r.n = y.n + d;
+            }
+            return r;
+        }
+        case OP_LNOT: { r.l = to_double(y) == 0; return r; }
+        default: { r.l = ~to_long(y); return r; }
+    }
+}
+
+/**
+ * @brief Aplica um kernel binário a um elemento __y__ e ao segundo operando __x__.
+ *
+ * @param op Operação.
+ * @param y Elemento.
+ * @param x Segundo operando.
+ * @return DADOS Retorna o resultado.
+ */
+DADOS kernel_binary(OPCODE op, DADOS y, DADOS x)
+{
+    DADOS r;
+    double a = to_double(x);
+    double b = to_double(y);
+    int longs = x.tipo == LONG && y.tipo == LONG;
+
+    r.tipo = LONG;
+
+    switch (op)
+    {
+        case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV:
+        {
+            if (longs)
+                return op == OP_ADD ? long_add(y.l, x.l) : op == OP_SUB ? long_sub(y.l, x.l) :
+                       op == OP_MUL ? long_mul(y.l, x.l) : long_div(y.l, x.l);
+
+            r.tipo = DOUBLE;
+            r.n = op == OP_ADD ? b + a : op == OP_SUB ? b - a : op == OP_MUL ? b * a : b / a;
+            return r;
+        }
+        case OP_MOD:
+            return long_mod(to_long(y), to_long(x));
+        case OP_EXPO:
+        {
+            if (longs)
+                r = int_pow(y, x.l);
+            else
+            {
+                r.tipo = DOUBLE;
+                r.n = pow(b, a);
+            }
+            return r;
+        }
+        case OP_BAND: { r.l = to_long(y) & to_long(x); return r; }
+        case OP_BOR: { r.l = to_long(y) | to_long(x); return r; }
+        case OP_BXOR: { r.l = to_long(y) ^ to_long(x); return r; }
+        case OP_EQUAL: { r.l = longs ? y.l == x.l : b == a; return r; }
+        case OP_SMALLER: { r.l = num_compare(y, x) < 0; return r; }
+        case OP_BIGGER: { r.l = num_compare(y, x) > 0; return r; }
+        case OP_MIN: return num_compare(y, x) < 0 ? y : x;
+        case OP_MAX: return num_compare(y, x) > 0 ? y : x;
+        case OP_AND:
+        {
+            if (a != 0 && b != 0)
+                return x;
+            r.l = 0;
+            return r;
+        }
+        default:
+        {
+            if (a == 0 && b == 0)
+            {
+                r.l = 0;
+                return r;
+            }
+            return b == 0 ? x : y;
+        }
+    }
+}
+
+/**
+ * @brief Aplica um kernel a um elemento.
+ *
+ * O kernel só é aplicado a números e caracteres (e, na forma `{ _ op }`, apenas a números), bem como às strings em `{ i }` e `{ f }`.
+ * Nos restantes casos o bloco tem de ser executado normalmente.
+ *
+ * @param k Kernel.
+ * @param e Elemento.
+ * @param r Endereço onde é guardado o resultado.
+ * @return int Retorna 1 caso o kernel tenha sido aplicado, ou 0 caso contrário.
+ */
+int kernel_apply(KERNEL* k, DADOS e, DADOS* r)
+{
+    if (e.tipo == STRING && k->forma == KERNEL_UNARIO && (k->op == OP_INT || k->op == OP_DOUBLE))
+    {
+        STR *a = e.dados;
+
+        if (k->op == OP_INT)
+            *r = big_parse(a->str, a->len);
+        else
+        {
+            r->tipo = DOUBLE;
+            r->n = parse_double(a->str, a->len);
+        }
+        return 1;
+    }
+    if (e.tipo != LONG && e.tipo != DOUBLE && (e.tipo != CHAR || k->forma == KERNEL_DUP))
+        return 0;
+
+    if (k->forma == KERNEL_UNARIO)
+        *r = kernel_unary(k->op, e);
+    else
+        *r = kernel_binary(k->op, e, k->forma == KERNEL_DUP ? e : k->lit);
+
+    return 1;
+}
+
+/**
+ * @brief Ciclo que executa `CORPO` para o valor `v` (do tipo `T`, lido com `LER`) e o segundo operando `w` de cada elemento.
+ */
+#define KERNEL_CICLO(T, LER, CORPO)                         \
+    for (long i = 1; i <= n; i++)                           \
+    {                                                       \
+        T v = (LER);                                        \
+        T w = dup ? v : lit_##T;                            \
+        (void)w;                                            \
+        CORPO;                                              \
+    }
+
+/**
+ * @brief Ciclo `KERNEL_CICLO` sobre os valores do array, consoante o seu formato (um ciclo próprio para cada formato).
+ */
+#define KERNEL_LOOP(T, CORPO)                                           \
+    {                                                                   \
+        if (array->formato == LONGS)                                    \
+            KERNEL_CICLO(T, array->longs[i], CORPO)                     \
+        else if (array->formato == DOUBLES)                             \
+            KERNEL_CICLO(T, array->doubles[i], CORPO)                   \
+        else if (array->formato == INTERVALO)                           \
+            KERNEL_CICLO(T, inicio + (i - 1) * passo, CORPO)            \
+        else if (tipo == LONG)                                          \
+            KERNEL_CICLO(T, array->stack[i].l, CORPO)                   \
+        else                                                            \
+            KERNEL_CICLO(T, array->stack[i].n, CORPO)                   \
+    }
+
+/**
+ * @brief Aplica um kernel a um intervalo, dando outro intervalo, quando a operação é uma soma, subtração ou multiplicação por uma
+ * constante inteira (`{ 2 * }`, `{ 1 + }`, `{ _ + }`, `{ ( }`, ...), que transforma uma progressão aritmética noutra.
+ * 
+ * O resultado só é calculado desta forma quando os valores dos extremos (e, por isso, todos os valores intermédios) e o novo passo
+ * cabem num `long`, para que seja igual ao da aplicação do operador a cada elemento.
+ * 
+ * @param k Kernel.
+ * @param array Intervalo.
+ * @return STACK* Retorna o intervalo de resultados, ou NULL caso a operação não transforme o intervalo noutro intervalo.
+ */
+STACK* map_range(KERNEL* k, STACK* array)
+{
+    long n = array->sp;
+    long passo, total;
+    DADOS y[3], r[3];
+
+    if (k->forma == KERNEL_UNARIO ? k->op != OP_DECR && k->op != OP_INCR :
+        k->op != OP_ADD && k->op != OP_SUB && (k->op != OP_MUL || k->forma == KERNEL_DUP))
+        return NULL;
+    if (k->forma == KERNEL_LITERAL && k->lit.tipo != LONG)
+        return NULL;
+
+    y[0] = array_get(array, 1);
+    y[1] = array_get(array, n > 1 ? 2 : 1);
+    y[2] = array_get(array, n);
+
+    for (int i = 0; i < 3; i++)
+        if (!kernel_apply(k, y[i], &r[i]) || r[i].tipo != LONG)
+            return NULL;
+
+    if (__builtin_sub_overflow(r[1].l, r[0].l, &passo) || __builtin_sub_overflow(r[2].l, r[0].l, &total))
+        return NULL;
+
+    return new_range(r[0].l, passo, n);
+}
+
+/**
+ * @brief Aplica um kernel a todos os elementos de um array homogéneo (apenas LONG ou apenas DOUBLE), com um ciclo sem ramificações por
+ * elemento para as operações aritméticas e de comparação mais comuns.
+ *
+ * Os arrays compactos e os intervalos são lidos diretamente e o resultado é também um array compacto (`LONGS` ou `DOUBLES`), ou um
+ * intervalo (`map_range()`). Os arrays de strings em `{ i }` e `{ f }` são convertidos de uma só vez por `parse_strings()` e os arrays
+ * de números em `{ s }` por `format_strings()`.
+ *
+ * As somas, subtrações e multiplicações de inteiros são feitas em inteiros de 64 bits e o overflow é acumulado ao longo do ciclo; caso
+ * algum resultado não caiba num `long`, o array é processado elemento a elemento (e esses resultados passam a ser DOUBLE).
+ *
+ * @param k Kernel.
+ * @param array Array.
+ * @return STACK* Retorna o array de resultados, ou NULL caso o array não seja homogéneo, a operação não tenha um ciclo próprio ou algum
+ * resultado inteiro não caiba num `long`.
+ */
+STACK* kernel_map(KERNEL* k, STACK* array)
+{
+    long n = array->sp;
+    int dup = k->forma == KERNEL_DUP;
+    long lit_long = k->lit.tipo == LONG ? k->lit.l : 0;
+    double lit_double = k->lit.tipo == DOUBLE ? k->lit.n : lit_long;
+    TIPO tipo = array->formato == DOUBLES ? DOUBLE : LONG;
+    long inicio = array->inicio, passo = array->passo;
+    int excede = 0;
+
+    if (n == 0 || (k->forma == KERNEL_LITERAL && k->lit.tipo != LONG && k->lit.tipo != DOUBLE))
+        return NULL;
+
+    if (k->forma == KERNEL_UNARIO && (k->op == OP_INT || k->op == OP_DOUBLE) && array->formato == GENERICO &&
+        array->stack[1].tipo == STRING)
+        return parse_strings(array, k->op == OP_INT);
+    if (k->forma == KERNEL_UNARIO && k->op == OP_STRING)
+        return format_strings(array);
+
+    if (array->formato == INTERVALO)
+    {
+        STACK *r = map_range(k, array);
+        if (r != NULL)
+            return r;
+    }
+    else if (array->formato == GENERICO)
+    {
+        tipo = array->stack[1].tipo;
+        if (tipo != LONG && tipo != DOUBLE)
+            return NULL;
+        for (long i = 2; i <= n; i++)
+            if (array->stack[i].tipo != tipo)
+                return NULL;
+    }
+
+    int longs = tipo == LONG && (dup || k->lit.tipo == LONG);
+    FORMATO formato;
+
+    switch (k->op)
+    {
+        case OP_ADD: case OP_SUB: case OP_MUL: case OP_DECR: case OP_INCR:
+            formato = longs ? LONGS : DOUBLES;
+            break;
+        case OP_EQUAL: case OP_SMALLER: case OP_BIGGER: case OP_LNOT:
+            formato = LONGS;
+            break;
+        case OP_DOUBLE:
+            formato = DOUBLES;
+            break;
+        default:
+            return NULL;
+    }
+
+    STACK *r = new_array(formato, n);
+
+    switch (k->op)
+    {
+        case OP_ADD:
+            if (longs) KERNEL_LOOP(long, excede |= __builtin_add_overflow(v, w, &r->longs[i]))
+            else KERNEL_LOOP(double, r->doubles[i] = v + w)
+            break;
+        case OP_SUB:
+            if (longs) KERNEL_LOOP(long, excede |= __builtin_sub_overflow(v, w, &r->longs[i]))
+            else KERNEL_LOOP(double, r->doubles[i] = v - w)
+            break;
+        case OP_MUL:
+            if (longs) KERNEL_LOOP(long, excede |= __builtin_mul_overflow(v, w, &r->longs[i]))
+            else KERNEL_LOOP(double, r->doubles[i] = v * w)
+            break;
+        case OP_EQUAL:
+            if (longs) KERNEL_LOOP(long, r->longs[i] = v == w) else KERNEL_LOOP(double, r->longs[i] = v == w)
+            break;
+        case OP_SMALLER:
+            if (longs) KERNEL_LOOP(long, r->longs[i] = v < w) else KERNEL_LOOP(double, r->longs[i] = v < w)
+            break;
+        case OP_BIGGER:
+            if (longs) KERNEL_LOOP(long, r->longs[i] = v > w) else KERNEL_LOOP(double, r->longs[i] = v > w)
+            break;
+        case OP_DECR:
+            if (tipo == LONG) KERNEL_LOOP(long, excede |= __builtin_sub_overflow(v, 1L, &r->longs[i]))
+            else KERNEL_LOOP(double, r->doubles[i] = v - 1)
+            break;
+        case OP_INCR:
+            if (tipo == LONG) KERNEL_LOOP(long, excede |= __builtin_add_overflow(v, 1L, &r->longs[i]))
+            else KERNEL_LOOP(double, r->doubles[i] = v + 1)
+            break;
+        case OP_LNOT:
+            if (tipo == LONG) KERNEL_LOOP(long, r->longs[i] = v == 0) else KERNEL_LOOP(double, r->longs[i] = v == 0)
+            break;
+        default: KERNEL_LOOP(double, r->doubles[i] = v) break;
+    }
+
+    if (excede)
+        return NULL;
+
+    r->sp = n;
+    return r;
+}
@@ -0,0 +1,201 @@
+/**
+ * @file parallel.c
+ * @brief Conjunto de threads (*worker pool*) que executa tarefas independentes em paralelo.
+ *
+ * As threads são criadas na primeira utilização e ficam à espera de trabalho, pelo que cada `parallel_for()` apenas as acorda. As tarefas
+ * são distribuídas dinamicamente: cada thread retira o índice da próxima tarefa por executar até que não reste nenhuma.
+ *
+ * As tarefas não têm arena própria: uma tarefa que aloque valores deve criar a sua arena com `new_arena()` e torná-la a atual com
+ * `arena_switch()`, uma vez que a arena atual é própria de cada thread.
+ */
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/sysinfo.h>
+#include "stack.h"
+
+#define PARALELO_MIN 4096 ///< Número de elementos, por omissão, a partir do qual as operações sobre arrays são feitas em paralelo.
+
+/**
+ * @brief Definição do conjunto de threads e do trabalho que está a ser executado.
+ *
+ * - `threads`: __Threads auxiliares (a thread que chama `parallel_for()` também executa tarefas).__
+ * - `f`, `ctx`, `n`: __Trabalho atual: tarefas `f(ctx, 0)` a `f(ctx, n - 1)`.__
+ * - `proxima`: __Índice da próxima tarefa por executar.__
+ * - `geracao`: __Número do trabalho atual, incrementado sempre que é submetido um novo trabalho.__
+ * - `ativas`: __Número de threads auxiliares que ainda não terminaram o trabalho atual.__
+ */
+typedef struct
+{
+    pthread_t *threads; ///< Threads auxiliares.
+    int n_threads; ///< Número de threads auxiliares.
+    pthread_mutex_t mutex; ///< Protege `geracao` e `ativas`.
+    pthread_cond_t trabalho; ///< Sinaliza um novo trabalho.
+    pthread_cond_t fim; ///< Sinaliza o fim do trabalho de todas as threads auxiliares.
+    void (*f)(void *ctx, long i); ///< Tarefa.
+    void *ctx; ///< Contexto das tarefas.
+    long n; ///< Número de tarefas.
+    atomic_long proxima; ///< Próxima tarefa.
+    long geracao; ///< Número do trabalho atual.
+    int ativas; ///< Threads ocupadas.
+} POOL;
+
+static POOL pool; ///< Conjunto de threads do processo.
+
+/**
+ * @brief Indica se a thread atual está a executar tarefas, caso em que um `parallel_for()` encaixado é executado sequencialmente.
+ */
+static _Thread_local int em_paralelo = 0;
+
+/**
+ * @brief Lê uma variável de ambiente numérica.
+ *
+ * @param nome Nome da variável.
+ * @param omissao Valor a devolver caso a variável não exista.
+ * @return long Retorna o valor da variável.
+ */
+long env_long(const char *nome, long omissao)
+{
+    char *env = getenv(nome);
+    return env ? atol(env) : omissao;
+}
+
+/**
+ * @brief Devolve o número de threads a utilizar: o valor da variável de ambiente `OM_THREADS`, caso exista, ou o número de processadores.
+ *
+ * @return int Retorna o número de threads (pelo menos 1).
+ */
+int num_threads()
+{
+    static int n = 0;
+
+    if (n == 0)
+    {
+        n = env_long("OM_THREADS", get_nprocs());
+        if (n < 1)
+            n = 1;
+    }
+
+    return n;
+}
+
+/**
+ * @brief Devolve o número de elementos a partir do qual as operações sobre arrays são repartidas pelas threads: o valor da variável de
+ * ambiente `OM_PARALELO_MIN`, caso exista, ou `PARALELO_MIN`.
+ *
+ * @return long Retorna o número mínimo de elementos.
+ */
+long parallel_threshold()
+{
+    static long n = -1;
+
+    if (n < 0)
+    {
+        n = env_long("OM_PARALELO_MIN", PARALELO_MIN);
+        if (n < 1)
+            n = 1;
+    }
+
+    return n;
+}
+
+/**
+ * @brief Executa tarefas do trabalho atual até que não reste nenhuma.
+ */
+void run_tasks()
+{
+    long i;
+
+    em_paralelo = 1;
+    while ((i = atomic_fetch_add(&pool.proxima, 1)) < pool.n)
+        pool.f(pool.ctx, i);
+    em_paralelo = 0;
+}
+
+/**
+ * @brief Ciclo de uma thread auxiliar: espera por um novo trabalho, executa tarefas e avisa quando termina.
+ *
+ * @param arg Não utilizado.
+ * @return void* Nunca retorna.
+ */
+void* worker(void *arg)
+{
+    long geracao = 0;
+    (void)arg;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&pool.mutex);
+        while (pool.geracao == geracao)
+            pthread_cond_wait(&pool.trabalho, &pool.mutex);
+        geracao = pool.geracao;
+        pthread_mutex_unlock(&pool.mutex);
+
+        run_tasks();
+
+        pthread_mutex_lock(&pool.mutex);
+        if (--pool.ativas == 0)
+            pthread_cond_signal(&pool.fim);
+        pthread_mutex_unlock(&pool.mutex);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Cria as threads auxiliares (`num_threads() - 1`), caso ainda não existam.
+ */
+void start_pool()
+{
+    if (pool.threads != NULL)
+        return;
+
+    pthread_mutex_init(&pool.mutex, NULL);
+    pthread_cond_init(&pool.trabalho, NULL);
+    pthread_cond_init(&pool.fim, NULL);
+
+    pool.threads = malloc(sizeof(pthread_t) * num_threads());
+    for (int t = 0; t < num_threads() - 1; t++)
+        if (pthread_create(&pool.threads[pool.n_threads], NULL, worker, NULL) == 0)
+            pool.n_threads++;
+}
+
+/**
+ * @brief Executa as tarefas `f(ctx, 0)` a `f(ctx, n - 1)`, distribuídas pelas threads disponíveis, e espera que todas terminem.
+ *
+ * A thread que chama a função executa também tarefas. Com uma só thread (ou quando chamada a partir de uma tarefa), as tarefas são
+ * executadas por ordem.
+ *
+ * @param n Número de tarefas.
+ * @param f Função que executa uma tarefa.
+ * @param ctx Contexto partilhado por todas as tarefas.
+ */
+void parallel_for(long n, void (*f)(void *ctx, long i), void *ctx)
+{
+    if (n <= 1 || num_threads() <= 1 || em_paralelo)
+    {
+        for (long i = 0; i < n; i++)
+            f(ctx, i);
+        return;
+    }
+
+    start_pool();
+
+    pthread_mutex_lock(&pool.mutex);
+    pool.f = f;
+    pool.ctx = ctx;
+    pool.n = n;
+    atomic_store(&pool.proxima, 0);
+    pool.ativas = pool.n_threads;
+    pool.geracao++;
+    pthread_cond_broadcast(&pool.trabalho);
+    pthread_mutex_unlock(&pool.mutex);
+
+    run_tasks();
+
+    pthread_mutex_lock(&pool.mutex);
+    while (pool.ativas > 0)
+        pthread_cond_wait(&pool.fim, &pool.mutex);
+    pthread_mutex_unlock(&pool.mutex);
+}
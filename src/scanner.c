@@ -0,0 +1,191 @@
+/**
+ * @file scanner.c
+ * @brief Índice estrutural do texto de um programa, construído com instruções SIMD, utilizado pelo analisador léxico.
+ *
+ * Cada bloco de 64 caracteres é classificado de uma só vez: cada caracter é comparado em paralelo com os delimitadores (espaço, '\0',
+ * '\n', ']', '}' e '"') e as comparações são reduzidas a três palavras de 64 bits, uma por `MAPA`. O analisador léxico salta depois
+ * diretamente para o próximo bit ativo do mapa respetivo, pelo que o custo de um token longo (um número, uma palavra ou uma string) não
+ * depende de um teste por caracter.
+ *
+ * A classificação é feita com AVX2 quando o processador o suporta (verificado durante a execução), com SSE2 nos restantes processadores
+ * x86-64 e por uma tabela nos restantes casos e no fim do texto.
+ */
+
+#include "stack.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define INDICE_SIMD
+#endif
+
+/**
+ * @brief Classes dos caracteres utilizadas pela classificação sem SIMD: bit 0 para os espaços, bit 1 para os caracteres que terminam uma
+ * palavra e bit 2 para os caracteres que terminam uma string.
+ */
+static const unsigned char classe[256] = {[' '] = 3, ['\0'] = 6, ['\n'] = 2, [']'] = 2, ['}'] = 2, ['"'] = 4};
+
+/**
+ * @brief Classifica até 64 caracteres através da tabela das classes. As posições a seguir aos __n__ caracteres ficam ativas em todos os mapas.
+ *
+ * @param t Caracteres.
+ * @param n Número de caracteres.
+ * @param r Endereço onde são guardadas as palavras de cada mapa.
+ */
+static void classify_scalar(const char* t, int n, uint64_t r[3])
+{
+    uint64_t fim = n < 64 ? ~0ULL << n : 0;
+
+    r[0] = r[1] = r[2] = fim;
+    for (int i = 0; i < n; i++)
+    {
+        uint64_t c = classe[(unsigned char) t[i]];
+
+        r[MAPA_TOKENS] |= (~c & 1) << i;
+        r[MAPA_PALAVRAS] |= (c >> 1 & 1) << i;
+        r[MAPA_STRINGS] |= (c >> 2 & 1) << i;
+    }
+}
+
+#ifdef INDICE_SIMD
+
+/**
+ * @brief Classifica 64 caracteres com SSE2, 16 de cada vez.
+ *
+ * @param t Caracteres.
+ * @param r Endereço onde são guardadas as palavras de cada mapa.
+ */
+static void classify_sse2(const char* t, uint64_t r[3])
+{
+    r[0] = r[1] = r[2] = 0;
+    for (int i = 0; i < 64; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*) (t + i));
+        __m128i espaco = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+        __m128i nulo = _mm_cmpeq_epi8(v, _mm_setzero_si128());
+        __m128i fecho = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(']')), _mm_cmpeq_epi8(v, _mm_set1_epi8('}')));
+        __m128i palavra = _mm_or_si128(_mm_or_si128(espaco, nulo), _mm_or_si128(fecho, _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+        __m128i string = _mm_or_si128(nulo, _mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+
+        r[MAPA_TOKENS] |= (uint64_t) (~_mm_movemask_epi8(espaco) & 0xffff) << i;
+        r[MAPA_PALAVRAS] |= (uint64_t) _mm_movemask_epi8(palavra) << i;
+        r[MAPA_STRINGS] |= (uint64_t) _mm_movemask_epi8(string) << i;
+    }
+}
+
+/**
+ * @brief Classifica 64 caracteres com AVX2, 32 de cada vez.
+ *
+ * @param t Caracteres.
+ * @param r Endereço onde são guardadas as palavras de cada mapa.
+ */
+__attribute__((target("avx2")))
+static void classify_avx2(const char* t, uint64_t r[3])
+{
+    r[0] = r[1] = r[2] = 0;
+    for (int i = 0; i < 64; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (t + i));
+        __m256i espaco = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+        __m256i nulo = _mm256_cmpeq_epi8(v, _mm256_setzero_si256());
+        __m256i fecho = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(']')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('}')));
+        __m256i palavra = _mm256_or_si256(_mm256_or_si256(espaco, nulo), _mm256_or_si256(fecho, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+        __m256i string = _mm256_or_si256(nulo, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')));
+
+        r[MAPA_TOKENS] |= (uint64_t) ~(uint32_t) _mm256_movemask_epi8(espaco) << i;
+        r[MAPA_PALAVRAS] |= (uint64_t) (uint32_t) _mm256_movemask_epi8(palavra) << i;
+        r[MAPA_STRINGS] |= (uint64_t) (uint32_t) _mm256_movemask_epi8(string) << i;
+    }
+}
+
+#endif
+
+/**
+ * @brief Constrói os mapas da janela do índice que começa na palavra __k__ (ou seja, no caracter `64 * k`).
+ *
+ * @param ind Índice.
+ * @param k Primeira palavra da janela.
+ */
+static void index_fill(INDICE* ind, long k)
+{
+    long n = (ind->len + 63) / 64 - k;
+    uint64_t r[3];
+
+    if (n > JANELA_INDICE)
+        n = JANELA_INDICE;
+
+#ifdef INDICE_SIMD
+    int avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+    for (long j = 0; j < n; j++)
+    {
+        long i = (k + j) * 64;
+
+#ifdef INDICE_SIMD
+        if (i + 64 <= ind->len && avx2)
+            classify_avx2(ind->texto + i, r);
+        else if (i + 64 <= ind->len)
+            classify_sse2(ind->texto + i, r);
+        else
+#endif
+            classify_scalar(ind->texto + i, i + 64 <= ind->len ? 64 : ind->len - i, r);
+
+        for (int m = 0; m < 3; m++)
+            ind->mapas[m][j] = r[m];
+    }
+
+    ind->base = k;
+}
+
+/**
+ * @brief Inicializa o índice estrutural de um texto. Os mapas são construídos à medida que o analisador léxico avança.
+ *
+ * @param ind Índice.
+ * @param texto Texto do programa.
+ * @param len Comprimento do texto.
+ */
+void index_init(INDICE* ind, const char* texto, long len)
+{
+    ind->texto = texto;
+    ind->len = len;
+    ind->pos = 0;
+    ind->base = -1;
+}
+
+/**
+ * @brief Devolve a palavra __k__ de um mapa, construindo a janela que a contém caso esta ainda não tenha sido construída.
+ *
+ * @param ind Índice.
+ * @param m Mapa.
+ * @param k Palavra (de 64 caracteres).
+ * @return uint64_t Retorna a palavra do mapa (com todos os bits ativos a seguir ao fim do texto).
+ */
+static uint64_t index_word(INDICE* ind, MAPA m, long k)
+{
+    if (k * 64 >= ind->len)
+        return ~0ULL;
+    if (ind->base < 0 || k < ind->base || k >= ind->base + JANELA_INDICE)
+        index_fill(ind, k);
+
+    return ind->mapas[m][k - ind->base];
+}
+
+/**
+ * @brief Procura, no mapa __m__, a primeira posição ativa a partir da posição __pos__ (por exemplo, o fim da palavra que começa em __pos__).
+ *
+ * @param ind Índice.
+ * @param m Mapa.
+ * @param pos Posição inicial.
+ * @return long Retorna a posição encontrada, ou o comprimento do texto caso não exista nenhuma.
+ */
+long index_next(INDICE* ind, MAPA m, long pos)
+{
+    long k = pos / 64;
+    uint64_t w = index_word(ind, m, k) & ~0ULL << (pos % 64);
+
+    while (w == 0)
+        w = index_word(ind, m, ++k);
+
+    pos = k * 64 + __builtin_ctzll(w);
+    return pos < ind->len ? pos : ind->len;
+}
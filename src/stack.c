@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include "stack.h"
 
 // Declaração de nova stack
@@ -13,17 +14,613 @@
 /**
  * @brief Aloca espaço na memória *heap* atribuindo um endereço ao pointer __s__ e iniciando o stack pointer (`s->sp`) a 0.
  * 
+ * A stack começa com uma capacidade pequena (`STACK_INICIAL`), que cresce geometricamente com `grow_stack()` à medida que são introduzidos elementos.
+ * 
  * @return s Retorna o endereço da "STACK" declarada em `main()`, agora inicializada.
  */
 STACK* new_stack()
 {
-    STACK *s = malloc(sizeof(STACK));
+    return new_stack_cap(STACK_INICIAL);
+}
+
+/**
+ * @brief Aloca uma nova stack com capacidade exata para __n__ elementos, utilizada quando o tamanho final de um array é conhecido.
+ * 
+ * @param n Número de elementos.
+ * @return STACK* Retorna o endereço da nova stack.
+ */
+STACK* new_stack_cap(int n)
+{
+    return new_array(GENERICO, n);
+}
+
+/**
+ * @brief Devolve o tamanho de cada elemento guardado num dado formato.
+ * 
+ * @param formato Formato.
+ * @return size_t Retorna o número de bytes de cada elemento.
+ */
+size_t elem_size(FORMATO formato)
+{
+    if (formato == LONGS)
+        return sizeof(long);
+    else if (formato == DOUBLES)
+        return sizeof(double);
+    else
+        return sizeof(DADOS);
+}
+
+/**
+ * @brief Aloca um novo array com capacidade exata para __n__ elementos, guardados no formato __formato__.
+ * 
+ * @param formato Formato dos elementos.
+ * @param n Número de elementos.
+ * @return STACK* Retorna o endereço do novo array.
+ */
+STACK* new_array(FORMATO formato, int n)
+{
+    STACK *s = arena_alloc(sizeof(STACK));
     s->sp = 0;
-    s->cap = 150000;
-    s->stack = malloc(sizeof(DADOS) * s->cap);
+    s->cap = n + 1;                     // A posição 0 não é utilizada
+    s->formato = formato;
+    s->partilhado = 0;
+    s->stack = arena_alloc(elem_size(formato) * s->cap);
     return s;
 }
 
+/**
+ * @brief Garante que a stack tem capacidade para mais __n__ elementos, duplicando a capacidade as vezes necessárias.
+ * 
+ * O crescimento geométrico faz com que o custo de introduzir __n__ elementos seja O(n), independentemente do tamanho inicial da stack.
+ * 
+ * @param s Stack.
+ * @param n Número de elementos a introduzir.
+ */
+void grow_stack(STACK* s, int n)
+{
+    if (s->sp + n < s->cap)
+        return;
+
+    int cap = s->cap > 0 ? s->cap : STACK_INICIAL;
+    while (s->sp + n >= cap)
+        cap *= 2;
+
+    s->stack = arena_realloc(s->stack, elem_size(s->formato) * s->cap, elem_size(s->formato) * cap);
+    s->cap = cap;
+}
+
+/**
+ * @brief Cria um intervalo de __n__ elementos LONG: `inicio`, `inicio + passo`, ..., sem alocar memória para os elementos. Como o custo não
+ * depende de __n__, um intervalo com mais de `ARRAY_MAX` elementos é rejeitado (`check_length()`) em vez de ser truncado.
+ * 
+ * @param inicio Primeiro elemento.
+ * @param passo Diferença entre elementos consecutivos.
+ * @param n Número de elementos.
+ * @return STACK* Retorna o endereço do novo intervalo.
+ */
+STACK* new_range(long inicio, long passo, long n)
+{
+    STACK *s = arena_alloc(sizeof(STACK));
+    s->sp = n > 0 ? check_length(n) : 0;
+    s->cap = s->sp + 1;
+    s->formato = INTERVALO;
+    s->partilhado = 0;
+    s->inicio = inicio;
+    s->passo = passo;
+    return s;
+}
+
+/**
+ * @brief Verifica o comprimento de um array que não é alocado de uma vez (uma `ARVORE` ou um `INTERVALO`), e que por isso pode exceder
+ * `ARRAY_MAX` sem que a memória se esgote. Um comprimento maior termina o programa com uma mensagem de erro, em vez de ser truncado.
+ * 
+ * @param n Comprimento.
+ * @return int Retorna o comprimento.
+ */
+int check_length(long n)
+{
+    if (n > ARRAY_MAX)
+    {
+        fprintf(stderr, "Erro: array com %ld elementos (máximo %d)\n", n, ARRAY_MAX);
+        exit(EXIT_FAILURE);
+    }
+
+    return n;
+}
+
+/**
+ * @brief Verifica que __i__ é um índice (a partir de 0) de um array ou de uma string de comprimento __n__. Os arrays em árvore e os
+ * intervalos calculariam um valor plausível para um índice inválido, pelo que um índice fora do array termina o programa com uma
+ * mensagem de erro.
+ * 
+ * @param i Índice.
+ * @param n Comprimento.
+ * @return long Retorna o índice.
+ */
+long check_index(long i, long n)
+{
+    if (i < 0 || i >= n)
+    {
+        fprintf(stderr, "Erro: índice %ld fora de um array com %ld elementos\n", i, n);
+        exit(EXIT_FAILURE);
+    }
+
+    return i;
+}
+
+// Acesso aos elementos de um array
+
+/**
+ * @brief Devolve o elemento na posição __i__ (a partir de 1) de um array, qualquer que seja o seu formato.
+ * 
+ * @param a Array.
+ * @param i Posição.
+ * @return DADOS Retorna o elemento.
+ */
+DADOS array_get(STACK *a, long i)
+{
+    DADOS d;
+
+    while (a->formato == ARVORE)
+    {
+        if (i <= a->esq->sp)
+            a = a->esq;
+        else
+        {
+            i -= a->esq->sp;
+            a = a->dir;
+        }
+    }
+
+    if (a->formato == LONGS)
+    {
+        d.tipo = LONG;
+        d.l = a->longs[i];
+    }
+    else if (a->formato == DOUBLES)
+    {
+        d.tipo = DOUBLE;
+        d.n = a->doubles[i];
+    }
+    else if (a->formato == INTERVALO)
+    {
+        d.tipo = LONG;
+        d.l = a->inicio + (i - 1) * a->passo;
+    }
+    else
+        d = a->stack[i];
+
+    return d;
+}
+
+/**
+ * @brief Guarda um elemento na posição __i__ de um array. Num array compacto, o elemento tem de ser do tipo dos restantes (um intervalo
+ * é primeiro convertido com `materialize()` e uma vista copiada com `unshare()`).
+ * 
+ * @param a Array.
+ * @param i Posição.
+ * @param d Elemento.
+ */
+void array_set(STACK *a, long i, DADOS d)
+{
+    materialize(a);
+    unshare(a);
+
+    if (a->formato == LONGS)
+        a->longs[i] = d.l;
+    else if (a->formato == DOUBLES)
+        a->doubles[i] = d.n;
+    else
+        a->stack[i] = d;
+}
+
+/**
+ * @brief Passa um array compacto ao formato genérico, no próprio lugar (o valor do array não muda).
+ * 
+ * @param a Array.
+ * @return DADOS* Retorna os elementos do array, no formato genérico.
+ */
+DADOS* flatten(STACK *a)
+{
+    if (a->formato == GENERICO)
+        return a->stack;
+
+    DADOS *stack = arena_alloc(sizeof(DADOS) * a->cap);
+    for (long i = 1; i <= a->sp; i++)
+        stack[i] = array_get(a, i);
+
+    a->stack = stack;
+    a->formato = GENERICO;
+    a->partilhado = 0;
+    return stack;
+}
+
+/**
+ * @brief Converte um intervalo num array `LONGS` (e uma árvore num array contíguo), no próprio lugar, para que lhe possam ser acrescentados
+ * ou alterados elementos.
+ * 
+ * @param a Array.
+ */
+void materialize(STACK *a)
+{
+    if (a->formato == ARVORE)
+        *a = *linearize(a);
+    if (a->formato != INTERVALO)
+        return;
+
+    long inicio = a->inicio, passo = a->passo;
+    long *longs = arena_alloc(sizeof(long) * a->cap);
+
+    for (long i = 1; i <= a->sp; i++)
+        longs[i] = inicio + (i - 1) * passo;
+
+    a->longs = longs;
+    a->formato = LONGS;
+}
+
+/**
+ * @brief Copia os elementos de uma vista, para que esta possa ser alterada sem alterar o array original.
+ * 
+ * @param a Array.
+ */
+void unshare(STACK *a)
+{
+    if (!a->partilhado)
+        return;
+
+    size_t tam = elem_size(a->formato);
+    void *elementos = arena_alloc(tam * (a->sp + 1));
+
+    memcpy((char*)elementos + tam, (char*)a->stack + tam, tam * a->sp);
+    a->stack = elementos;
+    a->cap = a->sp + 1;
+    a->partilhado = 0;
+}
+
+/**
+ * @brief Devolve o formato de um array construído a partir de elementos de __a__ (um intervalo dá origem a um array `LONGS` e uma árvore
+ * ao formato comum das suas folhas, caso exista).
+ * 
+ * @param a Array.
+ * @return FORMATO Retorna o formato.
+ */
+FORMATO result_format(STACK *a)
+{
+    if (a->formato == ARVORE)
+    {
+        FORMATO esq = result_format(a->esq);
+        return esq == result_format(a->dir) ? esq : GENERICO;
+    }
+
+    return a->formato == INTERVALO ? LONGS : a->formato;
+}
+
+/**
+ * @brief Passa um array genérico que só contém números do mesmo tipo ao formato compacto correspondente (`LONGS` ou `DOUBLES`).
+ * 
+ * @param a Array.
+ */
+void pack(STACK *a)
+{
+    if (a->formato != GENERICO || a->sp == 0)
+        return;
+
+    TIPO tipo = a->stack[1].tipo;
+    if (tipo != LONG && tipo != DOUBLE)
+        return;
+    for (long i = 1; i <= a->sp; i++)
+        if (a->stack[i].tipo != tipo)
+            return;
+
+    STACK *r = new_array(tipo == LONG ? LONGS : DOUBLES, a->sp);
+    for (long i = 1; i <= a->sp; i++)
+        array_set(r, i, a->stack[i]);
+    r->sp = a->sp;
+
+    *a = *r;
+}
+
+/**
+ * @brief Acrescenta um elemento ao fim de um array em construção. O array mantém o formato compacto enquanto os elementos forem do
+ * mesmo tipo; caso contrário passa ao formato genérico. Um intervalo é primeiro convertido num array `LONGS` e uma vista é copiada.
+ * 
+ * @param a Array.
+ * @param d Elemento.
+ */
+void array_push(STACK *a, DADOS d)
+{
+    materialize(a);
+    unshare(a);
+
+    if ((a->formato == LONGS && d.tipo == LONG) || (a->formato == DOUBLES && d.tipo == DOUBLE))
+    {
+        grow_stack(a, 1);
+        a->sp++;
+        array_set(a, a->sp, d);
+    }
+    else
+    {
+        flatten(a);
+        push(a, d);
+    }
+}
+
+/**
+ * @brief Acrescenta ao fim de __r__ os __n__ elementos de __a__ a partir da posição __ini__. Os elementos são copiados de uma só vez
+ * quando os dois arrays têm o mesmo formato (no caso de uma árvore, folha a folha).
+ * 
+ * @param r Array em construção.
+ * @param a Array de origem.
+ * @param ini Posição do primeiro elemento a copiar.
+ * @param n Número de elementos.
+ */
+void array_append(STACK *r, STACK *a, long ini, long n)
+{
+    if (n <= 0)
+        return;
+
+    if (a->formato == ARVORE)
+    {
+        long esq = a->esq->sp;
+        long k = ini > esq ? 0 : esq - ini + 1 < n ? esq - ini + 1 : n;
+
+        array_append(r, a->esq, ini, k);
+        array_append(r, a->dir, ini + k - esq, n - k);
+        return;
+    }
+
+    materialize(r);
+    unshare(r);
+    if (r->formato == LONGS && a->formato == INTERVALO)
+    {
+        grow_stack(r, n);
+        for (long i = 0; i < n; i++)
+            r->longs[r->sp + 1 + i] = a->inicio + (ini - 1 + i) * a->passo;
+    }
+    else if (r->formato != a->formato)
+    {
+        flatten(r);
+        grow_stack(r, n);
+        for (long i = 0; i < n; i++)
+            r->stack[r->sp + 1 + i] = array_get(a, ini + i);
+    }
+    else
+    {
+        size_t tam = elem_size(r->formato);
+
+        grow_stack(r, n);
+        memcpy((char*)r->stack + tam * (r->sp + 1), (char*)a->stack + tam * ini, tam * n);
+    }
+    r->sp += n;
+}
+
+// Árvores de concatenação
+
+/**
+ * @brief Cria um novo cabeçalho para os elementos de um array, sem os copiar. Os nós de uma árvore são partilhados por vários arrays,
+ * pelo que um array que sai de `array_concat()`, `array_repeat()` ou `array_slice()` tem sempre um cabeçalho próprio, que pode ser alterado.
+ * 
+ * @param a Array.
+ * @return STACK* Retorna o endereço do novo cabeçalho.
+ */
+STACK* clone_header(STACK *a)
+{
+    STACK *r = arena_alloc(sizeof(STACK));
+    *r = *a;
+    return r;
+}
+
+/**
+ * @brief Devolve a altura de um array numa árvore de concatenação (0 caso o array não seja uma `ARVORE`).
+ * 
+ * @param a Array.
+ * @return int Retorna a altura.
+ */
+int height(STACK *a)
+{
+    return a->formato == ARVORE ? a->altura : 0;
+}
+
+/**
+ * @brief Cria um nó de uma árvore que representa a concatenação de __esq__ e __dir__.
+ * 
+ * @param esq Primeira parte.
+ * @param dir Segunda parte.
+ * @return STACK* Retorna o endereço do novo nó.
+ */
+STACK* new_node(STACK *esq, STACK *dir)
+{
+    STACK *s = arena_alloc(sizeof(STACK));
+    s->esq = esq;
+    s->dir = dir;
+    s->sp = esq->sp + dir->sp;
+    s->altura = 1 + (height(esq) > height(dir) ? height(esq) : height(dir));
+    s->formato = ARVORE;
+    s->partilhado = 0;
+    return s;
+}
+
+/**
+ * @brief Cria um nó com as partes __esq__ e __dir__, cujas alturas diferem no máximo em 2, fazendo uma rotação (simples ou dupla) caso
+ * a diferença seja 2, para que a árvore continue equilibrada.
+ * 
+ * @param esq Primeira parte.
+ * @param dir Segunda parte.
+ * @return STACK* Retorna o endereço do novo nó.
+ */
+STACK* balance(STACK *esq, STACK *dir)
+{
+    if (height(esq) > height(dir) + 1)
+    {
+        if (height(esq->esq) >= height(esq->dir))
+            return new_node(esq->esq, new_node(esq->dir, dir));
+        return new_node(new_node(esq->esq, esq->dir->esq), new_node(esq->dir->dir, dir));
+    }
+    if (height(dir) > height(esq) + 1)
+    {
+        if (height(dir->dir) >= height(dir->esq))
+            return new_node(new_node(esq, dir->esq), dir->dir);
+        return new_node(new_node(esq, dir->esq->esq), new_node(dir->esq->dir, dir->dir));
+    }
+
+    return new_node(esq, dir);
+}
+
+/**
+ * @brief Concatena dois arrays, partilhando os seus elementos. Um resultado pequeno (até `ARVORE_FOLHA` elementos) é copiado para um
+ * array contíguo; um array pequeno é juntado à folha da extremidade da árvore onde é acrescentado, para que acrescentar um elemento de
+ * cada vez não crie uma folha por elemento. Caso contrário, a árvore mais baixa é pendurada na mais alta, ao nível da sua altura.
+ * Um resultado com mais de `ARRAY_MAX` elementos é rejeitado (`check_length()`).
+ * 
+ * @param a Primeiro array.
+ * @param b Segundo array.
+ * @return STACK* Retorna a concatenação (que pode ser um dos arrays ou um nó partilhado).
+ */
+STACK* join(STACK *a, STACK *b)
+{
+    if (a->sp == 0)
+        return b;
+    if (b->sp == 0)
+        return a;
+
+    int n = check_length((long)a->sp + b->sp);
+
+    if (n <= ARVORE_FOLHA)
+    {
+        STACK *r = new_array(result_format(a), n);
+
+        array_append(r, a, 1, a->sp);
+        array_append(r, b, 1, b->sp);
+        return r;
+    }
+
+    if (height(a) > height(b) + 1 || (height(a) > 0 && b->sp < ARVORE_FOLHA))
+        return balance(a->esq, join(a->dir, b));
+    if (height(b) > height(a) + 1 || (height(b) > 0 && a->sp < ARVORE_FOLHA))
+        return balance(join(a, b->esq), b->dir);
+
+    return new_node(a, b);
+}
+
+/**
+ * @brief Devolve os __n__ (pelo menos 1) elementos de uma árvore a partir da posição __ini__, partilhando as subárvores que ficam inteiras.
+ * 
+ * @param a Array.
+ * @param ini Posição do primeiro elemento.
+ * @param n Número de elementos.
+ * @return STACK* Retorna a parte do array (que pode ser um nó partilhado).
+ */
+STACK* slice_tree(STACK *a, long ini, long n)
+{
+    if (ini == 1 && n == a->sp)
+        return a;
+    if (a->formato != ARVORE)
+        return array_slice(a, ini, n);
+
+    long esq = a->esq->sp;
+
+    if (ini + n - 1 <= esq)
+        return slice_tree(a->esq, ini, n);
+    if (ini > esq)
+        return slice_tree(a->dir, ini - esq, n);
+
+    return join(slice_tree(a->esq, ini, esq - ini + 1), slice_tree(a->dir, 1, ini + n - 1 - esq));
+}
+
+/**
+ * @brief Devolve os __n__ elementos de __a__ a partir da posição __ini__, em tempo constante: o resultado é uma vista que partilha os
+ * elementos de __a__ (ou, no caso de um intervalo, um novo intervalo), pelo que nenhum elemento é copiado. Uma parte de uma árvore
+ * (`slice_tree()`) custa O(log² n).
+ * 
+ * @param a Array.
+ * @param ini Posição do primeiro elemento.
+ * @param n Número de elementos.
+ * @return STACK* Retorna o endereço da vista.
+ */
+STACK* array_slice(STACK *a, long ini, long n)
+{
+    if (a->formato == ARVORE)
+        return clone_header(n > 0 ? slice_tree(a, ini, n) : new_stack_cap(0));
+    if (a->formato == INTERVALO)
+        return new_range(a->inicio + (ini - 1) * a->passo, a->passo, n);
+
+    STACK *r = arena_alloc(sizeof(STACK));
+    size_t tam = elem_size(a->formato);
+
+    r->stack = (void*)((char*)a->stack + tam * (ini - 1));
+    r->sp = n > 0 ? n : 0;
+    r->cap = r->sp + 1;
+    r->formato = a->formato;
+    r->partilhado = 1;
+    return r;
+}
+
+/**
+ * @brief Concatena dois arrays em O(log n), sem copiar os elementos de arrays grandes (ver `join()`).
+ * 
+ * @param a Primeiro array.
+ * @param b Segundo array.
+ * @return STACK* Retorna o endereço da concatenação.
+ */
+STACK* array_concat(STACK *a, STACK *b)
+{
+    return clone_header(join(a, b));
+}
+
+/**
+ * @brief Repete um array __n__ vezes. Um array pequeno é primeiro repetido até formar uma folha com perto de `ARVORE_FOLHA` elementos;
+ * a folha é depois duplicada sucessivamente (`join()` de uma árvore consigo própria), pelo que a repetição custa O(log² n) e todas as
+ * cópias partilham os mesmos elementos. Um resultado com mais de `ARRAY_MAX` elementos é rejeitado (`check_length()`).
+ * 
+ * @param a Array.
+ * @param n Número de repetições.
+ * @return STACK* Retorna o endereço do resultado.
+ */
+STACK* array_repeat(STACK *a, long n)
+{
+    if (n <= 0 || a->sp == 0)
+        return new_array(result_format(a), 0);
+    if (n <= ARVORE_FOLHA / a->sp)
+    {
+        STACK *r = new_array(result_format(a), n * a->sp);
+
+        for (long i = 0; i < n; i++)
+            array_append(r, a, 1, a->sp);
+        return r;
+    }
+
+    long k = a->sp < ARVORE_FOLHA ? ARVORE_FOLHA / a->sp : 1;
+    STACK *folha = k > 1 ? array_repeat(a, k) : a;
+    STACK *r = array_repeat(a, n % k);
+
+    for (long m = n / k; m > 0; m /= 2)
+    {
+        if (m % 2 == 1)
+            r = join(r, folha);
+        if (m > 1)
+            folha = join(folha, folha);
+    }
+
+    return clone_header(r);
+}
+
+/**
+ * @brief Devolve os elementos de um array guardados de forma contígua, para as operações que percorrem o array inteiro.
+ * 
+ * @param a Array.
+ * @return STACK* Retorna o próprio array ou, no caso de uma árvore, uma cópia dos seus elementos num novo array.
+ */
+STACK* linearize(STACK *a)
+{
+    if (a->formato != ARVORE)
+        return a;
+
+    STACK *r = new_array(result_format(a), a->sp);
+
+    array_append(r, a, 1, a->sp);
+    return r;
+}
+
 // Armazenamento de variáveis
 
 /**
@@ -37,28 +634,20 @@ void initialize_var(DADOS *var)
 
     for (i=0; i<=5; i++)
     {
-        double *r = malloc(sizeof(double));
-        *r = 10 + i;                    // *r toma valor 11, 12, 13, 14 ou 15 para A, B, C, D, E ou F (respetivamente)
         var[i].tipo = LONG;
-        var[i].dados = r;
+        var[i].l = 10 + i;              // Toma valor 10, 11, 12, 13, 14 ou 15 para A, B, C, D, E ou F (respetivamente)
     }
 
-    char *n = malloc(sizeof(char));
-    *n = '\n';                          // *n toma o valor '\n' para N
     var[13].tipo = CHAR;
-    var[13].dados = n;
+    var[13].c = '\n';                   // Toma o valor '\n' para N
 
-    char *s = malloc(sizeof(char));
-    *s = ' ';                           // *s toma o valor ' ' para S
     var[18].tipo = CHAR;
-    var[18].dados = s;
+    var[18].c = ' ';                    // Toma o valor ' ' para S
 
-    for (i=23; i<26; i++)               // *r toma valor 0, 1 ou 2 para X, Y ou Z (respetivamente).
+    for (i=23; i<26; i++)               // Toma valor 0, 1 ou 2 para X, Y ou Z (respetivamente).
     {
-        double *x = malloc(sizeof(double));
-        *x = i - 23;
         var[i].tipo = LONG;
-        var[i].dados = x;
+        var[i].l = i - 23;
     }
 }
 
@@ -67,154 +656,203 @@ void initialize_var(DADOS *var)
 /**
  * @brief Introduz um elemento do tipo LONG na stack, incrementando um valor ao stack pointer (`s->sp`), uma vez que o topo da stack aumenta.
  * 
- * Para isso, é alocada memória de modo a suportar o tamanho de um elemento do tipo LONG, uma vez que na stack é apenas guardado o valor do endereço
- * desta memória, e não o elemento em si.
+ * O valor é guardado diretamente no elemento da stack, pelo que não é alocada memória.
  * 
  * @param s Stack.
  * @param elem Elemento a introduzir na stack.
  */
-void push_long(STACK* s, double elem)
+void push_long(STACK* s, long elem)
 {
-    double *elemP = malloc(sizeof(double));
-    *elemP = elem;
-    
-    DADOS d = {LONG, elemP};
+    if (s->sp + 1 >= s->cap)
+        grow_stack(s, 1);
+
     s->sp++;
-    s->stack[s->sp] = d;
+    s->stack[s->sp].tipo = LONG;
+    s->stack[s->sp].l = elem;
 }
 
 /**
  * @brief Introduz um elemento do tipo DOUBLE na stack, incrementando um valor ao stack pointer (`s->sp`), uma vez que o topo da stack aumenta.
  * 
- * Para isso, é alocada memória de modo a suportar o tamanho de um elemento do tipo DOUBLE, uma vez que na stack é apenas guardado o valor do endereço
- * desta memória, e não o elemento em si.
+ * O valor é guardado diretamente no elemento da stack, pelo que não é alocada memória.
  * 
  * @param s Stack.
  * @param elem Elemento a introduzir na stack.
  */
 void push_double(STACK *s, double elem)
 {
-    double *elemP = malloc(sizeof(double));
-    *elemP = elem;
+    if (s->sp + 1 >= s->cap)
+        grow_stack(s, 1);
 
-    DADOS d = {DOUBLE, elemP};
     s->sp++;
-    s->stack[s->sp] = d;
+    s->stack[s->sp].tipo = DOUBLE;
+    s->stack[s->sp].n = elem;
 }
 
 /**
  * @brief Introduz um elemento do tipo CHAR na stack, incrementando um valor ao stack pointer (`s->sp`), uma vez que o topo da stack aumenta.
  * 
- * Para isso, é alocada memória de modo a suportar o tamanho de um elemento do tipo CHAR, uma vez que na stack é apenas guardado o valor do endereço
- * desta memória, e não o elemento em si.
+ * O valor é guardado diretamente no elemento da stack, pelo que não é alocada memória.
  * 
  * @param s Stack.
  * @param elem Elemento a introduzir na stack.
  */
 void push_char(STACK* s, char elem)
 {
-    char *elemP = malloc(sizeof(char));
-    *elemP = elem;
-    
-    DADOS d = {CHAR, elemP};
+    if (s->sp + 1 >= s->cap)
+        grow_stack(s, 1);
+
     s->sp++;
-    s->stack[s->sp] = d;
+    s->stack[s->sp].tipo = CHAR;
+    s->stack[s->sp].c = elem;
 }
 
 /**
  * @brief Introduz um elemento do tipo STRING na stack, incrementando um valor ao stack pointer (`s->sp`), uma vez que o topo da stack aumenta.
  * 
+ * A stack fica com a referência da string recebida, pelo que a contagem de referências não é alterada.
+ * 
  * @param s Stack.
  * @param elem String a introduzir na stack.
  */
-void push_string(STACK *s, char* elem)
+void push_string(STACK *s, STR* elem)
 {   
-    DADOS d = {STRING, elem};
+    if (s->sp + 1 >= s->cap)
+        grow_stack(s, 1);
+
     s->sp++;
-    s->stack[s->sp] = d;
+    s->stack[s->sp].tipo = STRING;
+    s->stack[s->sp].dados = elem;
 }
 
 /**
  * @brief Introduz um elemento do tipo ARRAY na stack, incrementando um valor ao stack pointer (`s->sp`), uma vez que o topo da stack aumenta.
  * 
- * Para isso, é utilizada a função `new_stack()` para inicializar a estrutura STACK que é utilizada para armazenar os elementos de um array.
+ * O array não é copiado: a stack passa a ser dona da estrutura STACK recebida, que deve ter sido criada com `new_stack()` ou `new_stack_cap()`.
  * 
  * @param s Stack.
  * @param elem Array a introduzir na stack.
  */
-void push_array(STACK *s, STACK elem)
+void push_array(STACK *s, STACK *elem)
 {
-    STACK *arrayP = new_stack();
-    *arrayP = elem;
+    if (s->sp + 1 >= s->cap)
+        grow_stack(s, 1);
 
-    DADOS d = {ARRAY, arrayP};
     s->sp++;
-    s->stack[s->sp] = d;
+    s->stack[s->sp].tipo = ARRAY;
+    s->stack[s->sp].dados = elem;
 }
 
 /**
  * @brief Introduz um elemento do tipo BLOCK na stack, incrementando um valor ao stack pointer (`s->sp`), uma vez que o topo da stack aumenta.
  * 
- * Para isso, é alocada memória de modo a suportar um array com "BUFSIZ" caracteres.
+ * O bloco não é copiado, pelo que todas as cópias partilham o mesmo texto e o mesmo programa compilado.
  * 
  * @param s Stack.
  * @param elem Bloco a ser introduzido na stack.
  */
-void push_block(STACK* s, char* elem)
+void push_block(STACK* s, BLOCO* elem)
 {
-    char *elemP = malloc(sizeof(char) * BUFSIZ);
-    strcpy(elemP, elem);
-    
-    DADOS d = {BLOCK, elemP};
+    if (s->sp + 1 >= s->cap)
+        grow_stack(s, 1);
+
     s->sp++;
-    s->stack[s->sp] = d;
+    s->stack[s->sp].tipo = BLOCK;
+    s->stack[s->sp].dados = elem;
 }
 
 /**
- * @brief Introduz um elemento na stack, direcionando para a função push correspondente de acordo com o seu tipo.
+ * @brief Introduz uma cópia de um elemento na stack.
+ * 
+ * As strings não são copiadas: a nova cópia partilha a string original, cuja contagem de referências é incrementada com `share()`.
+ * 
+ * - __Nota:__ Como os números e os caracteres são guardados diretamente no elemento, copiar um elemento destes tipos não aloca memória.
+ * No caso dos arrays é copiada apenas a estrutura STACK, que partilha os elementos com o original (um array que já foi introduzido na stack
+ * nunca cresce, apenas arrays em construção o fazem).
  * 
  * @param s Stack.
  * @param elem Elemento a introduzir na stack.
  */
 void push(STACK* s, DADOS elem)
 {
-    if (elem.tipo == LONG)
-    {
-        double *n = elem.dados;
-        push_long(s, *n);
-    }
-    else if (elem.tipo == DOUBLE)
+    if (elem.tipo == ARRAY)
     {
-        double *n = elem.dados;
-        push_double(s, *n);
+        STACK *n = arena_alloc(sizeof(STACK));
+        *n = *(STACK*)elem.dados;
+        push_array(s, n);
     }
-    else if (elem.tipo == CHAR)
-    {
-        char *n = elem.dados;
-        push_char(s, *n);
-    }
-    else if (elem.tipo == STRING)
-    {
-        char *n = elem.dados;
-        push_string(s, n);
-    }
-    else if (elem.tipo == BLOCK)
-    {
-        char* n = elem.dados;
-        push_block(s, n);
-    }
-    else if (elem.tipo == ARRAY)
-    {
-        STACK *n = elem.dados;
-        push_array(s, *n);
-    }
-    else if (elem.tipo == BLOCK)
+    else
     {
-        char *n = elem.dados;
-        push_block(s, n);
+        if (s->sp + 1 >= s->cap)
+            grow_stack(s, 1);
+
+        share(elem);
+        s->sp++;
+        s->stack[s->sp] = elem;
     }
 }
 
+/**
+ * @brief Regista uma nova referência para os dados de um elemento (apenas as strings contam referências).
+ * 
+ * @param d Elemento.
+ */
+void share(DADOS d)
+{
+    if (d.tipo == STRING && ((STR*)d.dados)->refs != STR_FIXA)
+        ((STR*)d.dados)->refs++;
+}
+
+/**
+ * @brief Regista que uma referência para os dados de um elemento deixou de existir (por exemplo, ao descartar o elemento com `;`).
+ * 
+ * @param d Elemento.
+ */
+void release(DADOS d)
+{
+    if (d.tipo == STRING)
+        str_release(d.dados);
+}
+
+/**
+ * @brief Devolve o valor numérico de um elemento do tipo LONG, DOUBLE, BIGINT ou CHAR (neste caso, o código do caracter).
+ * 
+ * @param d Elemento.
+ * @return double Retorna o valor numérico do elemento, ou 0 caso este não seja um número nem um caracter.
+ */
+double to_double(DADOS d)
+{
+    if (d.tipo == LONG)
+        return d.l;
+    else if (d.tipo == DOUBLE)
+        return d.n;
+    else if (d.tipo == CHAR)
+        return d.c;
+    else if (d.tipo == BIGINT)
+        return big_to_double(d.dados);
+    else
+        return 0;
+}
+
+/**
+ * @brief Devolve o valor inteiro de um elemento do tipo LONG, DOUBLE ou CHAR, truncando a parte decimal (de um BIGINT, apenas os seus
+ * 64 bits menos significativos, ver `big_to_long()`).
+ * 
+ * @param d Elemento.
+ * @return long Retorna o valor inteiro do elemento.
+ */
+long to_long(DADOS d)
+{
+    if (d.tipo == LONG)
+        return d.l;
+    else if (d.tipo == CHAR)
+        return d.c;
+    else if (d.tipo == BIGINT)
+        return big_to_long(d.dados);
+
+    return to_double(d);
+}
+
 // Função pop()
 
 /**
@@ -230,22 +868,3 @@ DADOS pop(STACK* s)
 
     return d;
 }
-
-/**
- * @brief Verifica se é necessário alocar mais memória para a stack, o que acontece quando esta atinge o limite de capacidade.
- * 
- * @param s Stack.
- * @return DADOS* Retorna o endereço do array de dados da stack.
- */
-DADOS* memory_checker(STACK* s)
-{
-    if (s->sp == s->cap)
-    {
-        s->cap += MAX_STACK;
-        int n = s->cap / MAX_STACK;
-        s->stack = realloc(s->stack, sizeof(DADOS) * n);
-        return s->stack;
-    }
-    else
-        return s->stack;
-}
@@ -1,4 +1,5 @@
 #include<stdlib.h>
+#include<stdint.h>
 /**
  * @file stack.h
  * @brief Declaração de funções e definição de estruturas de dados.
@@ -6,62 +7,369 @@
 
 // Definição de stack
 
-#define MAX_STACK 100000 ///< Capacidade da stack.
+#define STACK_INICIAL 8 ///< Capacidade inicial de uma stack cujo tamanho final não é conhecido.
+#define STR_FIXA 0x7fffffff ///< Contagem de referências de uma string partilhada entre threads, que deixa de ser contada e nunca é alterada.
+#define JANELA_INDICE 256 ///< Número de palavras de 64 bits de cada mapa do índice estrutural (janela de 16 KB do texto do programa).
+#define ARVORE_FOLHA 64 ///< Número de elementos até ao qual o resultado de uma concatenação é copiado, em vez de ser uma `ARVORE`.
+#define ARRAY_MAX 0x7ffffffe ///< Comprimento máximo de um array (o comprimento é um `int`), verificado onde uma árvore ou um intervalo o tornam alcançável.
+#define STR_MAX 0x7ffffffe ///< Comprimento máximo de uma string, verificado onde uma repetição (`*`) pedisse mais memória do que existe.
+#define KARATSUBA_LIMIAR 32 ///< Número de dígitos (de 32 bits) a partir do qual um `BIGINT` é multiplicado pelo algoritmo de Karatsuba.
 
 /**
  * @brief Definição de um tipo "__TIPO__" que representa o tipo do elemento da stack (long, double, char ou string).
  * 
+ * Um `BIGINT` é um inteiro que não cabe num `long`: os resultados inteiros só passam a `BIGINT` quando excedem um `long` e voltam a ser
+ * LONG sempre que lá cabem, pelo que um mesmo valor tem sempre o mesmo tipo.
  */
-typedef enum{LONG, DOUBLE, CHAR, STRING, ARRAY, BLOCK} TIPO; /**< Tipo dos dados. */
+typedef enum{LONG, DOUBLE, CHAR, STRING, ARRAY, BLOCK, BIGINT} TIPO; /**< Tipo dos dados. */
 
 /**
  * @brief Definição de uma estrutura "__DADOS__" que constitui os elementos da stack.
  * 
  * - `tipo`: __Tipo do elemento, definido em 'TIPO'.__
- * - `dados`: __ Endereço do elemento.__
+ * - `l`: __Valor do elemento, caso este seja do tipo LONG (um inteiro de 64 bits).__
+ * - `n`: __Valor do elemento, caso este seja do tipo DOUBLE.__
+ * - `c`: __Valor do elemento, caso este seja do tipo CHAR.__
+ * - `dados`: __Endereço do elemento, caso este seja do tipo STRING, ARRAY, BLOCK ou BIGINT.__
  * 
- * - __Nota:__ O endereço do elemento é do tipo `void` para que possa alocar um elemento de qualquer tipo. Por este motivo, sempre que se pretende
- * aceder ao conteúdo deste endereço, ou seja, ao conteúdo do elemento, deve-se explicitar o seu tipo. Por exemplo: `long n = *((long*)d.dados)`.
+ * - __Nota:__ Os números e os caracteres são guardados diretamente na estrutura (união etiquetada pelo `tipo`), pelo que não é alocada
+ * memória para estes elementos. Apenas as strings, os arrays e os blocos são guardados na memória *heap*, sendo o seu endereço do tipo `void`
+ * para que possa apontar para um elemento de qualquer um destes tipos. Por exemplo: `STACK *array = d.dados`.
  */
 typedef struct
 {
     TIPO tipo; ///< Tipo dos dados. 
-    void *dados; ///< Endereço do elemento 
+    union
+    {
+        long l; ///< Valor de um LONG.
+        double n; ///< Valor de um DOUBLE.
+        char c; ///< Valor de um CHAR.
+        void *dados; ///< Endereço de uma STRING, ARRAY, BLOCK ou BIGINT.
+    };
 } DADOS;
 
 /**
- * @brief Definição da estrutura da stack, denominada "__STACK__".
+ * @brief Definição da estrutura de uma string, denominada "__STR__".
  * 
- * "STACK" é contituída por: 
- * - Um array de 'DADOS' `stack[]` que representa a stack;
- * - Um inteiro `sp` que representa o topo da stack.
+ * - `str`: __Caracteres da string (terminados em '\0', exceto numa vista).__
+ * - `len`: __Comprimento da string.__
+ * - `cap`: __Número de caracteres que cabem em `str` sem realocar memória.__
+ * - `refs`: __Número de elementos (da stack, de arrays ou de variáveis) que partilham esta string.__
+ * - `base`: __String cujos caracteres são partilhados por esta (NULL caso a string seja dona dos seus caracteres).__
+ * - `usado`: __Número de caracteres de `str` ocupados pelas vistas que prolongam esta string (os primeiros `len` estão sempre ocupados).__
+ * 
+ * - __Nota:__ Uma string só pode ser alterada no próprio lugar quando `refs` é 1 e não é uma vista. Caso contrário deve ser copiada com
+ * `str_unique()`. Uma vista (criada por `str_slice()`) conta como uma referência da sua `base`, que por isso também não é alterada.
+ * A concatenação (`str_concat()`) pode ainda escrever no espaço livre a seguir a `usado`, que nenhuma string referencia, criando uma vista
+ * mais longa sem alterar as strings existentes.
+ * Uma string com `refs` igual a `STR_FIXA` pode ser lida por várias threads ao mesmo tempo, pelo que a sua contagem deixa de ser atualizada.
+ */
+typedef struct STR
+{
+    char *str; ///< Caracteres.
+    long len; ///< Comprimento.
+    long cap; ///< Capacidade.
+    int refs; ///< Número de referências.
+    struct STR *base; ///< String partilhada por uma vista.
+    long usado; ///< Caracteres ocupados.
+} STR;
+
+/**
+ * @brief Definição de um inteiro de precisão arbitrária, denominado "__INTEIRO__", guardado em sinal e módulo.
+ * 
+ * - `neg`: __1 caso o inteiro seja negativo, ou 0 caso contrário.__
+ * - `len`: __Número de dígitos do módulo (sem zeros à esquerda).__
+ * - `dig`: __Dígitos do módulo em base 2^32, do menos significativo para o mais significativo.__
+ * 
+ * - __Nota:__ Um INTEIRO nunca é alterado depois de criado, pelo que pode ser partilhado por várias cópias do elemento sem contar referências.
  */
 typedef struct
 {
-    DADOS* stack; ///< Stack. 
-    int sp; ///< Stack pointer 
-    int cap; ///< Capacidade da Stack. 
+    int neg; ///< Sinal.
+    long len; ///< Número de dígitos.
+    uint32_t dig[]; ///< Dígitos.
+} INTEIRO;
+
+/**
+ * @brief Definição do formato em que estão guardados os elementos de uma stack ou array, denominado "__FORMATO__".
+ *
+ * - `GENERICO`: __Elementos de qualquer tipo, guardados em `stack[]`.__
+ * - `LONGS`: __Array apenas de LONG, cujos valores são guardados de forma compacta em `longs[]`.__
+ * - `DOUBLES`: __Array apenas de DOUBLE, cujos valores são guardados de forma compacta em `doubles[]`.__
+ * - `INTERVALO`: __Progressão aritmética de LONG (`inicio`, `inicio + passo`, ...), cujos elementos não são guardados.__
+ * - `ARVORE`: __Concatenação dos arrays `esq` e `dir`, que são partilhados e não são copiados.__
+ */
+typedef enum {GENERICO, LONGS, DOUBLES, INTERVALO, ARVORE} FORMATO;
+
+/**
+ * @brief Definição da estrutura da stack, denominada "__STACK__".
+ *
+ * "STACK" é contituída por:
+ * - Um array de 'DADOS' `stack[]` que representa a stack;
+ * - Um inteiro `sp` que representa o topo da stack;
+ * - Um inteiro `cap` que representa o número de posições alocadas em `stack[]` (as posições válidas vão de 1 a `cap - 1`).
+ *
+ * - __Nota:__ Os arrays que só contêm números do mesmo tipo podem guardar apenas os valores (`longs[]` ou `doubles[]`, também a partir da
+ * posição 1), o que reduz a memória ocupada e permite percorrê-los com ciclos sem ramificações. Os elementos de um array devem ser lidos
+ * com `array_get()`, qualquer que seja o seu formato, e um array só passa ao formato genérico (`flatten()`) quando lhe é acrescentado um
+ * elemento de outro tipo. Um intervalo (criado por `,`) só guarda o primeiro elemento e a diferença entre elementos consecutivos, sendo
+ * convertido num array `LONGS` (`materialize()`) apenas quando lhe são acrescentados elementos. Uma parte de um array (`array_slice()`)
+ * é uma vista que partilha os elementos do array original (`partilhado`), sendo copiada (`unshare()`) antes de ser alterada.
+ *
+ * - __Nota:__ A concatenação e a repetição de arrays grandes (`array_concat()` e `array_repeat()`) constroem uma árvore equilibrada (AVL)
+ * cujas folhas são arrays de qualquer outro formato, pelo que custam O(log n) e partilham os elementos dos operandos. O acesso a um
+ * elemento desce a árvore e as operações que percorrem o array inteiro copiam-no primeiro para um array contíguo (`linearize()`).
+ */
+typedef struct STACK
+{
+    union
+    {
+        DADOS* stack; ///< Stack (formato `GENERICO`).
+        long* longs; ///< Valores de um array `LONGS`.
+        double* doubles; ///< Valores de um array `DOUBLES`.
+        struct
+        {
+            long inicio; ///< Primeiro elemento de um `INTERVALO`.
+            long passo; ///< Diferença entre elementos consecutivos de um `INTERVALO`.
+        };
+        struct
+        {
+            struct STACK *esq; ///< Primeira parte de uma `ARVORE`.
+            struct STACK *dir; ///< Segunda parte de uma `ARVORE`.
+        };
+    };
+    int sp; ///< Stack pointer
+    union
+    {
+        int cap; ///< Capacidade da Stack.
+        int altura; ///< Altura de uma `ARVORE` (as folhas têm altura 0).
+    };
+    FORMATO formato; ///< Formato dos elementos.
+    int partilhado; ///< 1 caso os elementos pertençam a outro array (vista), ou 0 caso contrário.
 } STACK;
 
+/**
+ * @brief Definição dos códigos de operação ("__OPCODE__") que constituem um programa compilado.
+ * 
+ * Cada operador da linguagem corresponde a um único código, pelo que a classificação dos tokens é feita uma única vez, durante a compilação.
+ */
+typedef enum
+{
+    OP_NOP, OP_LIT, OP_STR, OP_ARRAY, OP_BLOCK,
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_DECR, OP_INCR, OP_MOD, OP_EXPO, OP_MODPOW,
+    OP_BAND, OP_BOR, OP_BXOR, OP_BNOT,
+    OP_LINE, OP_LINES, OP_WHILE,
+    OP_INT, OP_DOUBLE, OP_CHAR, OP_STRING,
+    OP_DUP, OP_POP, OP_SWAP, OP_SPIN, OP_NCOPY,
+    OP_EQUAL, OP_SMALLER, OP_BIGGER, OP_LNOT, OP_IF, OP_AND, OP_OR, OP_MIN, OP_MAX,
+    OP_RANGE, OP_DIV_NEWLINE, OP_DIV_WS,
+    OP_GET_VAR, OP_SET_VAR
+} OPCODE;
+
+struct PROGRAMA;
+
+/**
+ * @brief Definição de uma instrução de um programa compilado, denominada "__INSTRUCAO__".
+ * 
+ * - `op`: __Código da operação.__
+ * - `arg`: __Argumento inteiro (índice da variável em `OP_GET_VAR`/`OP_SET_VAR`).__
+ * - `lit`: __Literal já interpretado (números, strings e blocos).__
+ * - `sub`: __Programa aninhado (conteúdo de um array literal).__
+ */
+typedef struct
+{
+    OPCODE op; ///< Código da operação.
+    int arg; ///< Argumento inteiro.
+    DADOS lit; ///< Literal.
+    struct PROGRAMA *sub; ///< Programa aninhado.
+} INSTRUCAO;
+
+/**
+ * @brief Definição de um programa compilado, denominado "__PROGRAMA__", que é um array compacto de instruções.
+ */
+typedef struct PROGRAMA
+{
+    INSTRUCAO *instr; ///< Instruções.
+    int n; ///< Número de instruções.
+    int cap; ///< Capacidade do array de instruções.
+} PROGRAMA;
+
+/**
+ * @brief Formas de bloco executadas diretamente por um kernel: `{ op }`, `{ literal op }` e `{ _ op }`.
+ */
+typedef enum {KERNEL_UNARIO, KERNEL_LITERAL, KERNEL_DUP} FORMA;
+
+/**
+ * @brief Definição de um kernel, denominado "__KERNEL__", que aplica um bloco simples a um elemento sem executar o seu programa.
+ * 
+ * - `op`: __Operação.__
+ * - `forma`: __Forma do bloco (define o segundo operando das operações binárias).__
+ * - `lit`: __Literal (segundo operando na forma `{ literal op }`).__
+ */
+typedef struct
+{
+    OPCODE op; ///< Operação.
+    FORMA forma; ///< Forma do bloco.
+    DADOS lit; ///< Literal.
+} KERNEL;
+
+/**
+ * @brief Definição da estrutura de um bloco, denominada "__BLOCO__".
+ * 
+ * O programa de um bloco literal é compilado juntamente com o programa onde este aparece e partilhado por todas as cópias do bloco,
+ * pelo que o texto do bloco nunca volta a ser dividido em tokens. O texto é uma vista sobre o programa original (não terminada em '\0');
+ * um bloco promovido para outra arena recebe uma cópia do texto e é compilado na sua primeira execução.
+ */
+typedef struct
+{
+    const char *texto; ///< Texto do bloco (utilizado na impressão).
+    int len; ///< Comprimento do texto.
+    PROGRAMA *prog; ///< Programa compilado (NULL enquanto o bloco não for executado).
+} BLOCO;
+
+/**
+ * @brief Tipos de token ("__TIPO_TOKEN__") produzidos pelo analisador léxico (`next_token()`).
+ * 
+ * - `TOKEN_FIM`: __Fim do programa.__
+ * - `TOKEN_PALAVRA`: __Operador, variável ou número.__
+ * - `TOKEN_STRING`: __String literal (o token é o seu conteúdo, sem as aspas).__
+ * - `TOKEN_ABRE_ARRAY`, `TOKEN_FECHA_ARRAY`, `TOKEN_ABRE_BLOCO` e `TOKEN_FECHA_BLOCO`: __'[', ']', '{' e '}'.__
+ */
+typedef enum {TOKEN_FIM, TOKEN_PALAVRA, TOKEN_STRING, TOKEN_ABRE_ARRAY, TOKEN_FECHA_ARRAY, TOKEN_ABRE_BLOCO, TOKEN_FECHA_BLOCO} TIPO_TOKEN;
+
+/**
+ * @brief Definição de um token, denominado "__TOKEN__": uma vista sobre o texto do programa, que não é copiado.
+ */
+typedef struct
+{
+    const char *ini; ///< Primeiro caracter do token.
+    int len; ///< Comprimento do token.
+    TIPO_TOKEN tipo; ///< Tipo do token.
+} TOKEN;
+
+/**
+ * @brief Mapas de bits ("__MAPA__") do índice estrutural, com um bit por caracter do texto.
+ * 
+ * - `MAPA_TOKENS`: __Caracteres que não são espaços (início do próximo token).__
+ * - `MAPA_PALAVRAS`: __Caracteres que terminam uma palavra (' ', '\0', '\n', ']' e '}').__
+ * - `MAPA_STRINGS`: __Caracteres que terminam uma string ('"' e '\0').__
+ */
+typedef enum {MAPA_TOKENS, MAPA_PALAVRAS, MAPA_STRINGS} MAPA;
+
+/**
+ * @brief Definição do índice estrutural de um programa, denominado "__INDICE__", utilizado pelo analisador léxico.
+ * 
+ * Os mapas são construídos com instruções SIMD (SSE2 ou AVX2, consoante o processador), 64 caracteres de cada vez, para uma janela do
+ * texto que avança juntamente com o analisador. O início e o fim de cada token são encontrados a partir do próximo bit ativo do mapa
+ * respetivo, sem percorrer o texto caracter a caracter. As posições a seguir ao fim do texto estão ativas em todos os mapas.
+ */
+typedef struct
+{
+    const char *texto; ///< Texto do programa.
+    long len; ///< Comprimento do texto.
+    long pos; ///< Posição atual do analisador léxico.
+    long base; ///< Primeira palavra de 64 bits guardada na janela (-1 enquanto esta estiver vazia).
+    uint64_t mapas[3][JANELA_INDICE]; ///< Mapas da janela atual, indexados por `MAPA`.
+} INDICE;
+
+/**
+ * @brief Definição de um bloco de memória de uma arena, denominado "__BLOCO_ARENA__". A memória alocada segue-se ao cabeçalho.
+ */
+typedef struct BLOCO_ARENA
+{
+    struct BLOCO_ARENA *prox; ///< Bloco seguinte.
+    size_t usado; ///< Número de bytes já alocados.
+    size_t cap; ///< Capacidade do bloco.
+} BLOCO_ARENA;
+
+/**
+ * @brief Definição de uma arena, denominada "__ARENA__", onde são alocados todos os valores criados durante uma avaliação.
+ * 
+ * Os valores nunca são libertados individualmente: toda a memória de uma arena é libertada de uma só vez com `arena_release()`.
+ */
+typedef struct
+{
+    BLOCO_ARENA *blocos; ///< Blocos partilhados pelas alocações pequenas (o primeiro é o bloco atual).
+    BLOCO_ARENA *grandes; ///< Blocos próprios das alocações grandes.
+} ARENA;
+
+extern _Thread_local ARENA *arena_atual;
+
 // Declarações de funções
 
+// arena.c
+
+ARENA* new_arena();
+ARENA* arena_switch(ARENA *a);
+void* arena_alloc(size_t n);
+void* arena_realloc(void *p, size_t antigo, size_t n);
+void arena_adopt(ARENA *a, ARENA *outra);
+void arena_release(ARENA *a);
+DADOS promote(DADOS d);
+
 // stack.c
 
-DADOS* memory_checker(STACK* s);
 STACK* new_stack();
+STACK* new_stack_cap(int n);
+STACK* new_array(FORMATO formato, int n);
+STACK* new_range(long inicio, long passo, long n);
+int check_length(long n);
+long check_index(long i, long n);
+void grow_stack(STACK* s, int n);
+DADOS array_get(STACK *a, long i);
+void array_set(STACK *a, long i, DADOS d);
+DADOS* flatten(STACK *a);
+void materialize(STACK *a);
+void unshare(STACK *a);
+FORMATO result_format(STACK *a);
+void pack(STACK *a);
+void array_push(STACK *a, DADOS d);
+void array_append(STACK *r, STACK *a, long ini, long n);
+STACK* array_slice(STACK *a, long ini, long n);
+STACK* array_concat(STACK *a, STACK *b);
+STACK* array_repeat(STACK *a, long n);
+STACK* linearize(STACK *a);
 void remove_elem(STACK* s, int pos);
 void initialize_var(DADOS *var);
 void push_double(STACK *s, double elem);
-void push_long(STACK *s, double elem);
+void push_long(STACK *s, long elem);
 void push_char(STACK *s, char elem);
-void push_string(STACK *s, char elem[]);
-void push_array(STACK *s, STACK elem);
+void push_string(STACK *s, STR *elem);
+void push_array(STACK *s, STACK *elem);
 void push(STACK *s, DADOS elem);
 DADOS pop(STACK *s);
-void push_block(STACK* s, char* elem);
+void push_block(STACK* s, BLOCO* elem);
+void share(DADOS d);
+void release(DADOS d);
+double to_double(DADOS d);
+long to_long(DADOS d);
+
+// bigint.c
+
+INTEIRO* big_new(long len);
+DADOS big_value(INTEIRO *a);
+int is_integer(DADOS d);
+DADOS big_add(DADOS y, DADOS x);
+DADOS big_sub(DADOS y, DADOS x);
+DADOS big_mul(DADOS y, DADOS x);
+DADOS big_div(DADOS y, DADOS x);
+DADOS big_mod(DADOS y, DADOS x);
+int big_compare(DADOS a, DADOS b);
+long big_bits(DADOS d);
+DADOS big_mod_pow(DADOS b, DADOS e, DADOS m);
+double big_to_double(INTEIRO *a);
+long big_to_long(INTEIRO *a);
+STR* big_to_str(INTEIRO *a);
+DADOS big_parse(const char* s, long len);
 
 // expMat.c
 
+DADOS long_add(long b, long a);
+DADOS long_sub(long b, long a);
+DADOS long_mul(long b, long a);
+DADOS long_div(long b, long a);
+DADOS long_mod(long b, long a);
+DADOS int_pow(DADOS b, long e);
 void s_add(STACK *s);
 void subtract(STACK *s);
 void multiply(STACK *s, DADOS *var);
@@ -74,24 +382,26 @@ void decr(STACK *s);
 void incr(STACK *s);
 void mod(STACK *s, DADOS *var);
 void expo(STACK *s);
+void mod_pow(STACK *s);
 
 // io.c
 
-char* get_token(char* line, char token[]);
-char* get_token2(char* line, char *token, int* size, int* index,int* flag, int* str_flag, int*block_flag);
-char* get_token3(char* line, char *token, int* size, int* index,int* flag, int* str_flag, int*block_flag);
-void val(STACK* s, char* token);
-void handle_token(STACK* s, char* token, DADOS *var);
-void handle_token2(STACK* s, char* token, DADOS *var);
-void handle_token3(STACK* s, char* token, DADOS *var);
-void handle_token4(STACK* s, char* token, DADOS *var);
+DADOS val(const char* token, int len);
 void print_stack(STACK *s);
+STR* read_line();
 void new_line (STACK *s);
 void all_lines (STACK *s);
 char type_to_char(DADOS x);
+int format_long(long v, char *b);
+int format_g(double x, char *b);
 
 // conversions.c
 
+long parse_long(const char* s, long len);
+double parse_double(const char* s, long len);
+STACK* parse_strings(STACK* array, int inteiros);
+STR* number_to_str(DADOS d);
+STACK* format_strings(STACK* array);
 void conv_double(STACK *s);
 void conv_int(STACK *s);
 void conv_char(STACK *s);
@@ -107,6 +417,7 @@ void ncopy(STACK *s, DADOS *var);
 
 // expLogic.c
 
+int num_compare(DADOS a, DADOS b);
 void equal(STACK *s);
 void is_smaller(STACK *s);
 void is_bigger(STACK *s);
@@ -116,16 +427,19 @@ void or(STACK *s);
 void bigger(STACK *s);
 void smaller(STACK *s);
 void if_else(STACK* s);
+int compare(DADOS a, DADOS b);
 
 // expArrayString.c
 
-DADOS create_array(STACK* s, char* token, DADOS *var);
+void create_array(STACK* s, PROGRAMA* p, DADOS *var);
+void split_chars(STACK *s, const char *delim, int n);
 void div_newline(STACK *s);
 void div_whitespace(STACK *s);
 void range(STACK *s, DADOS *var);
 int substrings(STACK *s, DADOS a, DADOS b);
-void create_string(STACK *s, char* token);
+DADOS create_string(const char* s, int len);
 void slash_str(STACK* s, DADOS a, DADOS b);
+STACK* elem_array(DADOS d);
 void add_arrays(STACK *s, DADOS x, DADOS y);
 void add_char_array(STACK *s, DADOS x, DADOS y);
 void add_num_array(STACK *s, DADOS x, DADOS y);
@@ -134,13 +448,66 @@ void add_char_string(STACK *s, DADOS x, DADOS y);
 
 // stackBlocks.c
 
-DADOS create_block(STACK* s, char* token);
+DADOS create_block(const char* texto, int len, PROGRAMA* prog);
+PROGRAMA* block_program(DADOS block);
+int parallel_array(STACK* array, PROGRAMA* p, DADOS *var, int map);
+void parallel_map(STACK* s, STACK* array, PROGRAMA* p, KERNEL* kernel, DADOS *var);
+void parallel_filter(STACK* s, STACK* array, PROGRAMA* p, KERNEL* kernel, DADOS *var);
+void apply_block(STACK* s, DADOS e, PROGRAMA* p, KERNEL* k, DADOS *var);
 void execute_block_array(STACK* s, DADOS block, DADOS array, DADOS *var);
 void execute_block(STACK* s, DADOS block, DADOS *var);
 void execute_block_string(STACK* s, DADOS block, DADOS string, DADOS *var);
 void filter_array(STACK* s, DADOS b, DADOS a, DADOS *var);
 void filter_string(STACK* s, DADOS b, DADOS a, DADOS *var);
+DADOS fold_op(OPCODE op, DADOS y, DADOS x, int *inexato);
+int fold_kernel(STACK* s, STACK* array, OPCODE op);
 void fold_array(STACK* s, DADOS b, DADOS a, DADOS *var);
 void truthy(STACK* s, DADOS *var);
 int is_truthy(STACK* s);
 void sort(STACK* s, DADOS array, DADOS block, DADOS *var);
+
+// parallel.c
+
+long env_long(const char *nome, long omissao);
+int num_threads();
+long parallel_threshold();
+void parallel_for(long n, void (*f)(void *ctx, long i), void *ctx);
+
+// str.c
+
+STR* new_str_cap(long cap);
+long check_str_length(long n);
+STR* new_str(const char *s, long len);
+STR* str_unique(DADOS *d);
+STR* str_slice(DADOS *d, long ini, long n);
+void str_release(STR *a);
+const char* str_cstr(STR *a);
+void str_append(STR *a, const char *b, long n);
+STR* str_concat(DADOS *d, const char *b, long n);
+long str_find(STR *a, const char *b, long n, long from);
+int str_compare(STR *a, STR *b);
+int freeze(DADOS d);
+
+// kernels.c
+
+int block_kernel(PROGRAMA* p, KERNEL* k);
+DADOS kernel_unary(OPCODE op, DADOS y);
+DADOS kernel_binary(OPCODE op, DADOS y, DADOS x);
+int kernel_apply(KERNEL* k, DADOS e, DADOS* r);
+STACK* kernel_map(KERNEL* k, STACK* array);
+
+// scanner.c
+
+void index_init(INDICE* ind, const char* texto, long len);
+long index_next(INDICE* ind, MAPA m, long pos);
+
+// compiler.c
+
+TOKEN next_token(INDICE* ind);
+PROGRAMA* compile(const char* line, int len);
+void evaluate(STACK* s, DADOS *var, STR* line);
+TOKEN compile_tokens(PROGRAMA* p, INDICE* ind, TIPO_TOKEN fecho);
+void compile_token(PROGRAMA* p, TOKEN t);
+void run_program(STACK* s, PROGRAMA* p, DADOS *var);
+int pure_program(PROGRAMA* p, DADOS *var, int base, int *fim);
+OPCODE associative_op(PROGRAMA* p);
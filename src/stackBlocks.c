@@ -6,38 +6,55 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "stack.h"
+#include <math.h>
 #include <string.h>
+#include <limits.h>
 
 /**
- * @brief Cria um novo bloco, ou seja, um elemento do tipo BLOCK. `create_block()` recebe não só a stack, mas também uma string token que contém o
- * bloco introduzido no formato: `{ ... }`, onde `...` é um conjunto de operações, estas operações são guardadas numa string, de forma semelhante a como
- * um input do programa é guardado, e constituem os dados de um elemento do tipo BLOCK.
+ * @brief Cria um novo bloco, ou seja, um elemento do tipo BLOCK, a partir do texto entre as chavetas de um bloco introduzido no formato
+ * `{ ... }`, onde `...` é um conjunto de operações. O texto não é copiado: o bloco guarda uma vista sobre o input do programa.
  * 
- * @param s Stack.
- * @param token Bloco introduzido no formato: `{ ... }`.
- * @return DADOS Retorna um elemento do tipo BLOCK.
+ * @param texto Texto a seguir à chaveta de abertura.
+ * @param len Comprimento do texto (até à chaveta de fecho).
+ * @param prog Programa compilado do bloco.
+ * @return DADOS Retorna um elemento do tipo BLOCK, que é guardado como literal no programa compilado.
  */
-DADOS create_block(STACK* s, char* token)
+DADOS create_block(const char* texto, int len, PROGRAMA* prog)
 {
-    char* block = malloc(sizeof(char) * BUFSIZ);
+    BLOCO *b = arena_alloc(sizeof(BLOCO));
 
-    int index = 0;
-    
-    ++token;
-    for(int i = 0; *(token + i); ++i)
+    if (len > 0 && *texto == ' ')
     {
-        *(block + index) = *(token + i);
-        ++index;
+        ++texto;
+        --len;
     }
-    
-    *(block + index - 1) = '\0';
-    DADOS d = {BLOCK, ++block};
-    
-    s->sp++;
-    s->stack[s->sp] = d;
+
+    b->texto = texto;
+    b->len = len;
+    b->prog = prog;
+
+    DADOS d;
+    d.tipo = BLOCK;
+    d.dados = b;
     return d;
 }
 
+/**
+ * @brief Devolve o programa compilado de um bloco, compilando o seu texto apenas na primeira execução.
+ * 
+ * @param block Bloco.
+ * @return PROGRAMA* Retorna o programa compilado, partilhado por todas as cópias do bloco.
+ */
+PROGRAMA* block_program(DADOS block)
+{
+    BLOCO *b = block.dados;
+
+    if (b->prog == NULL)
+        b->prog = compile(b->texto, b->len);
+
+    return b->prog;
+}
+
 /**
  * @brief Executa as operações contidas num bloco.
  * 
@@ -47,19 +64,294 @@ DADOS create_block(STACK* s, char* token)
  */
 void execute_block(STACK* s, DADOS block, DADOS *var)
 {
-    char* line = block.dados; 
-    char* token = malloc(sizeof(char) * BUFSIZ);
+    PROGRAMA* p = block_program(block);
+    run_program(s, p, var);
+}
+
+/**
+ * @brief Estado partilhado pelas tarefas que aplicam um bloco, em paralelo, a troços de um array.
+ * 
+ * - `array`: __Array original.__
+ * - `p`, `k`, `var`: __Programa do bloco, kernel do bloco (caso exista) e variáveis.__
+ * - `tam`: __Número de elementos de cada troço.__
+ * - `res`, `arenas`: __Resultado de cada troço (`%`) e arena onde este foi alocado.__
+ * - `marca`: __Resultado da condição para cada elemento (`,`).__
+ * - `pos`: __Posição, no array final, do primeiro resultado de cada troço (soma de prefixos do número de resultados dos troços anteriores).__
+ * - `r`: __Array final.__
+ */
+typedef struct
+{
+    STACK *array; ///< Array original.
+    PROGRAMA *p; ///< Programa do bloco.
+    KERNEL *k; ///< Kernel do bloco (ou NULL).
+    DADOS *var; ///< Variáveis.
+    long tam; ///< Tamanho dos troços.
+    STACK **res; ///< Resultados de cada troço.
+    ARENA **arenas; ///< Arenas de cada troço.
+    char *marca; ///< Resultado da condição de cada elemento.
+    long *pos; ///< Posição de cada troço no array final.
+    STACK *r; ///< Array final.
+} TROCOS;
+
+/**
+ * @brief Decide se um bloco pode ser aplicado em paralelo aos elementos de um array: o array tem de ter pelo menos `parallel_threshold()`
+ * elementos (e nenhum bloco) e o bloco tem de ser puro (`pure_program()`).
+ * 
+ * @param array Array.
+ * @param p Programa do bloco.
+ * @param var Variáveis.
+ * @param map 1 para `%` (aplicar), 0 para `,` (filtrar, caso em que o bloco tem de deixar sempre um valor na stack).
+ * @return int Retorna 1 caso a execução possa ser feita em paralelo, ou 0 caso contrário.
+ */
+int parallel_array(STACK* array, PROGRAMA* p, DADOS *var, int map)
+{
+    int fim;
+    DADOS a;
+
+    if (array->sp < parallel_threshold() || num_threads() <= 1)
+        return 0;
+    if (!pure_program(p, var, 1, &fim) || (!map && fim < 1))
+        return 0;
+
+    a.tipo = ARRAY;
+    a.dados = array;
+    return freeze(a);
+}
+
+/**
+ * @brief Divide um array em troços, em número suficiente para equilibrar o trabalho entre as threads.
+ * 
+ * @param t Estado partilhado, onde é guardado o tamanho dos troços.
+ * @return long Retorna o número de troços.
+ */
+long split_chunks(TROCOS* t)
+{
+    long n = t->array->sp;
+    long k = num_threads() * 4L;
+
+    if (k > n)
+        k = n;
+    t->tam = (n + k - 1) / k;
+
+    return (n + t->tam - 1) / t->tam;
+}
+
+/**
+ * @brief Calcula a posição de cada troço no array final (soma de prefixos exclusiva), a partir do número de resultados de cada troço.
+ * 
+ * @param pos Número de resultados de cada troço, substituído pela posição do troço.
+ * @param k Número de troços.
+ * @return long Retorna o número total de resultados.
+ */
+long prefix_sum(long *pos, long k)
+{
+    long total = 0;
+
+    for (long i = 0; i < k; i++)
+    {
+        long n = pos[i];
+        pos[i] = total;
+        total += n;
+    }
+
+    return total;
+}
+
+/**
+ * @brief Tarefa que aplica o bloco aos elementos de um troço, numa stack e numa arena próprias.
+ * 
+ * @param ctx Estado partilhado.
+ * @param i Índice do troço.
+ */
+void map_chunk(void *ctx, long i)
+{
+    TROCOS *t = ctx;
+    long ini = i * t->tam + 1;
+    long fim = ini + t->tam - 1 < t->array->sp ? ini + t->tam - 1 : t->array->sp;
+
+    ARENA *a = new_arena();
+    ARENA *anterior = arena_switch(a);
+
+    STACK *r = new_stack_cap(fim - ini + 1);
+    for (long j = ini; j <= fim; j++)
+        apply_block(r, array_get(t->array, j), t->p, t->k, t->var);
+
+    arena_switch(anterior);
+    t->res[i] = r;
+    t->arenas[i] = a;
+    t->pos[i] = r->sp;
+}
+
+/**
+ * @brief Tarefa que copia os resultados de um troço para a sua posição no array final.
+ * 
+ * @param ctx Estado partilhado.
+ * @param i Índice do troço.
+ */
+void gather_chunk(void *ctx, long i)
+{
+    TROCOS *t = ctx;
+    memcpy(t->r->stack + 1 + t->pos[i], t->res[i]->stack + 1, sizeof(DADOS) * t->res[i]->sp);
+}
+
+/**
+ * @brief Versão paralela de `execute_block_array()`: cada troço do array é processado por uma tarefa e os resultados são juntados
+ * pela ordem original.
+ * 
+ * As arenas das tarefas passam a pertencer à arena atual, uma vez que os resultados foram alocados nelas.
+ * 
+ * @param s Stack.
+ * @param array Array.
+ * @param p Programa do bloco (puro).
+ * @param kernel Kernel do bloco (ou NULL).
+ * @param var Variáveis.
+ */
+void parallel_map(STACK* s, STACK* array, PROGRAMA* p, KERNEL* kernel, DADOS *var)
+{
+    TROCOS t = { array, p, kernel, var, 0, NULL, NULL, NULL, NULL, NULL };
+    long k = split_chunks(&t);
+
+    t.res = malloc(sizeof(STACK*) * k);
+    t.arenas = malloc(sizeof(ARENA*) * k);
+    t.pos = malloc(sizeof(long) * k);
 
-    while ((line = get_token(line, token)) && *line != '\0'){
-        //s->stack = memory_checker(s);
-        handle_token(s, token, var);
+    parallel_for(k, map_chunk, &t);
+
+    long total = prefix_sum(t.pos, k);
+    t.r = new_stack_cap(total);
+    t.r->sp = total;
+    parallel_for(k, gather_chunk, &t);
+    pack(t.r);
+
+    for (long i = 0; i < k; i++)
+    {
+        arena_adopt(arena_atual, t.arenas[i]);
+        arena_release(t.arenas[i]);
+    }
+
+    free(t.res);
+    free(t.arenas);
+    free(t.pos);
+
+    push_array(s, t.r);
+}
+
+/**
+ * @brief Tarefa que avalia a condição do bloco para os elementos de um troço, contando quantos a cumprem.
+ * 
+ * Os valores temporários são alocados numa arena própria, libertada no fim, uma vez que o array final só contém elementos do array original.
+ * 
+ * @param ctx Estado partilhado.
+ * @param i Índice do troço.
+ */
+void filter_chunk(void *ctx, long i)
+{
+    TROCOS *t = ctx;
+    long ini = i * t->tam + 1;
+    long fim = ini + t->tam - 1 < t->array->sp ? ini + t->tam - 1 : t->array->sp;
+    long n = 0;
+
+    ARENA *a = new_arena();
+    ARENA *anterior = arena_switch(a);
+
+    STACK *stack = new_stack();
+    for (long j = ini; j <= fim; j++)
+    {
+        stack->sp = 0;
+        apply_block(stack, array_get(t->array, j), t->p, t->k, t->var);
+
+        t->marca[j] = to_double(pop(stack)) != 0;
+        n += t->marca[j];
+    }
+
+    arena_switch(anterior);
+    arena_release(a);
+    t->pos[i] = n;
+}
+
+/**
+ * @brief Tarefa que copia os elementos de um troço que cumprem a condição para a sua posição no array final.
+ * 
+ * @param ctx Estado partilhado.
+ * @param i Índice do troço.
+ */
+void scatter_chunk(void *ctx, long i)
+{
+    TROCOS *t = ctx;
+    long ini = i * t->tam + 1;
+    long fim = ini + t->tam - 1 < t->array->sp ? ini + t->tam - 1 : t->array->sp;
+    long r = 1 + t->pos[i];
+
+    for (long j = ini; j <= fim; j++)
+        if (t->marca[j])
+            array_set(t->r, r++, array_get(t->array, j));
+}
+
+/**
+ * @brief Versão paralela de `filter_array()`: a condição é avaliada em paralelo para cada troço e os elementos escolhidos são
+ * compactados no array final, também em paralelo, a partir da soma de prefixos do número de elementos escolhidos em cada troço.
+ * 
+ * @param s Stack.
+ * @param array Array.
+ * @param p Programa do bloco (puro).
+ * @param kernel Kernel do bloco (ou NULL).
+ * @param var Variáveis.
+ */
+void parallel_filter(STACK* s, STACK* array, PROGRAMA* p, KERNEL* kernel, DADOS *var)
+{
+    TROCOS t = { array, p, kernel, var, 0, NULL, NULL, NULL, NULL, NULL };
+    long k = split_chunks(&t);
+
+    t.marca = malloc(array->sp + 1);
+    t.pos = malloc(sizeof(long) * k);
+
+    parallel_for(k, filter_chunk, &t);
+
+    long total = prefix_sum(t.pos, k);
+    t.r = new_array(result_format(array), total);
+    t.r->sp = total;
+    parallel_for(k, scatter_chunk, &t);
+
+    free(t.marca);
+    free(t.pos);
+
+    push_array(s, t.r);
+}
+
+/**
+ * @brief Aplica um bloco a um elemento, colocando o resultado na stack. O resultado é calculado pelo kernel do bloco, caso este exista e
+ * se aplique ao elemento; caso contrário, o elemento é colocado na stack e o programa do bloco é executado.
+ * 
+ * @param s Stack.
+ * @param e Elemento.
+ * @param p Programa do bloco.
+ * @param k Kernel do bloco (ou NULL).
+ * @param var Variáveis.
+ */
+void apply_block(STACK* s, DADOS e, PROGRAMA* p, KERNEL* k, DADOS *var)
+{
+    DADOS r;
+
+    if (k != NULL && kernel_apply(k, e, &r))
+    {
+        if (r.tipo == STRING)       // String nova (`{ s }`), cuja única referência passa para a stack
+            push_string(s, r.dados);
+        else
+            push(s, r);
+    }
+    else
+    {
+        push(s, e);
+        run_program(s, p, var);
     }
-    handle_token(s, token, var);
 }
 
 /**
  * @brief Aplica as operações contidas num bloco a cada elemento de um array e coloca na stack um novo array com os resultados das operações.
  * 
+ * Os arrays grandes são processados em paralelo com `parallel_map()`, caso o bloco seja puro. Os blocos simples são aplicados por um
+ * kernel (ver kernels.c), com um único ciclo quando o array é homogéneo.
+ * 
  * @param s Stack.
  * @param block Bloco.
  * @param array Array.
@@ -67,25 +359,28 @@ void execute_block(STACK* s, DADOS block, DADOS *var)
  */
 void execute_block_array(STACK* s, DADOS block, DADOS array, DADOS *var)
 {
-    STACK* old_arr = array.dados;
+    STACK* old_arr = linearize(array.dados);
+    PROGRAMA* p = block_program(block);
+    KERNEL kernel;
+    KERNEL* k = block_kernel(p, &kernel) ? &kernel : NULL;
 
-    STACK* new_arr = new_stack();
-    new_arr->cap = old_arr->cap;
-    new_arr->stack = malloc(sizeof(DADOS) * old_arr->cap);    
-    
-    char token[BUFSIZ];
-    char* line = malloc(sizeof(char) * BUFSIZ);
-    line = block.dados;
-    for(int i = 1; i <= old_arr->sp; ++i)
-    {
-        push(new_arr, old_arr->stack[i]);
-        while ((line = get_token(line, token)) && *line != '\0'){
-            handle_token(new_arr, token, var);
-        }
-        handle_token(new_arr, token, var);
-        line = block.dados;
+    if (parallel_array(old_arr, p, var, 1))
+    {
+        parallel_map(s, old_arr, p, k, var);
+        return;
+    }
+
+    STACK* new_arr = k != NULL ? kernel_map(k, old_arr) : NULL;
+
+    if (new_arr == NULL)
+    {
+        new_arr = new_stack_cap(old_arr->sp);
+        for(int i = 1; i <= old_arr->sp; ++i)
+            apply_block(new_arr, array_get(old_arr, i), p, k, var);
+        pack(new_arr);
     }
-    push_array(s, *new_arr);
+
+    push_array(s, new_arr);
 } 
 
 /**
@@ -98,28 +393,26 @@ void execute_block_array(STACK* s, DADOS block, DADOS array, DADOS *var)
  */
 void execute_block_string(STACK* s, DADOS block, DADOS string, DADOS *var)
 {
-    char* str = string.dados;
+    STR* str = string.dados;
     STACK* stack = new_stack();
-    char *r = malloc(sizeof(str));
+    STR* r = new_str_cap(str->len);
     
-    char token[BUFSIZ];
-    char* line = malloc(sizeof(char) * BUFSIZ);
-    line = block.dados;
-    int i;
-    for(i = 0; str[i] != '\0'; i++)
-    {
-        push_char(stack, str[i]);
-        while ((line = get_token(line, token)) && *line != '\0'){
-            handle_token(stack, token, var);
-        }
-        handle_token(stack, token, var);
-        
-        char *result = pop(stack).dados;
-        r[i] = *result;
+    PROGRAMA* p = block_program(block);
+    KERNEL kernel;
+    KERNEL* k = block_kernel(p, &kernel) ? &kernel : NULL;
+    DADOS c;
+    long i;
 
-        line = block.dados;
+    c.tipo = CHAR;
+    for(i = 0; i < str->len; i++)
+    {
+        c.c = str->str[i];
+        apply_block(stack, c, p, k, var);
+        
+        r->str[i] = to_long(pop(stack));
     }
-    r[i] = '\0';
+    r->str[i] = '\0';
+    r->len = i;
 
     push_string(s, r);
 }
@@ -128,6 +421,8 @@ void execute_block_string(STACK* s, DADOS block, DADOS string, DADOS *var)
  * @brief Filtra um array de acordo com a condição contida num bloco. Os elementos do array que cumprem a condição, ou seja, que dão um valor
  * diferente de 0 (true) quando aplicadas as operações, são colocados num novo array que é depois colocado na stack.
  * 
+ * Os arrays grandes são filtrados em paralelo com `parallel_filter()`, caso o bloco seja puro.
+ * 
  * @param s Stack.
  * @param b Bloco.
  * @param a Array.
@@ -135,29 +430,30 @@ void execute_block_string(STACK* s, DADOS block, DADOS string, DADOS *var)
  */
 void filter_array(STACK* s, DADOS b, DADOS a, DADOS *var)
 {
-    STACK *array = a.dados;
+    STACK *array = linearize(a.dados);
+    PROGRAMA* p = block_program(b);
+    KERNEL kernel;
+    KERNEL* k = block_kernel(p, &kernel) ? &kernel : NULL;
+
+    if (parallel_array(array, p, var, 0))
+    {
+        parallel_filter(s, array, p, k, var);
+        return;
+    }
+
     STACK *stack = new_stack();
-    STACK *r = new_stack();
+    STACK *r = new_array(result_format(array), STACK_INICIAL);
 
-    char token[BUFSIZ];
-    char* line = malloc(sizeof(char) * BUFSIZ);
-    line = b.dados;
     for(int i = 1; i <= array->sp; i++)
     {
-        push(stack, array->stack[i]);
-        while ((line = get_token(line, token)) && *line != '\0'){
-            handle_token(stack, token, var);
-        }
-        handle_token(stack, token, var);
+        DADOS e = array_get(array, i);
+        apply_block(stack, e, p, k, var);
         
-        double *result = pop(stack).dados;
-        if (*result != 0)
-            push(r, array->stack[i]);
-
-        line = b.dados;
+        if (to_double(pop(stack)) != 0)
+            array_push(r, e);
     }
 
-    push_array(s, *r);
+    push_array(s, r);
 }
 
 /**
@@ -171,40 +467,242 @@ void filter_array(STACK* s, DADOS b, DADOS a, DADOS *var)
  */
 void filter_string(STACK* s, DADOS block, DADOS string, DADOS *var)
 {
-    char *str = string.dados;
+    STR *str = string.dados;
     STACK *stack = new_stack();
-    char *r = malloc(sizeof(str));
+    STR *r = new_str_cap(str->len);
+
+    PROGRAMA* p = block_program(block);
+    KERNEL kernel;
+    KERNEL* k = block_kernel(p, &kernel) ? &kernel : NULL;
+    DADOS c;
+    long i, j;
 
-    char token[BUFSIZ];
-    char* line = malloc(sizeof(char) * BUFSIZ);
-    line = block.dados;
-    int i, j;
-    for(i = 0, j = 0; str[i] != '\0'; i++)
+    c.tipo = CHAR;
+    for(i = 0, j = 0; i < str->len; i++)
     {
-        push_char(stack, str[i]);
-        while ((line = get_token(line, token)) && *line != '\0'){
-            handle_token(stack, token, var);
-        }
-        handle_token(stack, token, var);
+        c.c = str->str[i];
+        apply_block(stack, c, p, k, var);
         
-        double *result = pop(stack).dados;
-        if (*result != 0)
+        if (to_double(pop(stack)) != 0)
         {
-            r[j] = str[i];
+            r->str[j] = str->str[i];
             j++;
         }
-
-        line = block.dados;
     }
-    r[j] = '\0';
+    r->str[j] = '\0';
+    r->len = j;
 
     push_string(s, r);
 }
 
+/**
+ * @brief Estado partilhado pelas tarefas de uma redução paralela.
+ * 
+ * - `array`: __Array a reduzir.__
+ * - `op`: __Operação associativa.__
+ * - `tam`: __Número de elementos de cada troço.__
+ * - `parcial`: __Resultado da redução de cada troço.__
+ * - `inexato`: __Indica se algum resultado intermédio inteiro não coube num `long`, caso em que o bloco é executado normalmente.__
+ */
+typedef struct
+{
+    STACK *array; ///< Array a reduzir.
+    OPCODE op; ///< Operação.
+    long tam; ///< Tamanho dos troços.
+    DADOS *parcial; ///< Resultados parciais.
+    int inexato; ///< Overflow de um resultado inteiro.
+} REDUCAO;
+
+/**
+ * @brief Aplica uma operação associativa a dois números, com o mesmo resultado que o operador correspondente (`s_add()`, `multiply()`,
+ * `bit_and()`, `bit_or()`, `bit_xor()`, `smaller()` e `bigger()`).
+ * 
+ * @param op Operação.
+ * @param y Primeiro operando.
+ * @param x Segundo operando.
+ * @param inexato Endereço onde é assinalado um resultado inteiro que não coube num `long` (o resultado devolvido não é utilizado).
+ * @return DADOS Retorna o resultado.
+ */
+DADOS fold_op(OPCODE op, DADOS y, DADOS x, int *inexato)
+{
+    DADOS r;
+    r.tipo = LONG;
+
+    switch (op)
+    {
+        case OP_ADD:
+        case OP_MUL:
+        {
+            if (x.tipo == LONG && y.tipo == LONG)
+            {
+                if (op == OP_ADD ? __builtin_add_overflow(y.l, x.l, &r.l) : __builtin_mul_overflow(y.l, x.l, &r.l))
+                    *inexato = 1;
+            }
+            else
+            {
+                r.tipo = DOUBLE;
+                r.n = op == OP_ADD ? to_double(y) + to_double(x) : to_double(y) * to_double(x);
+            }
+
+            return r;
+        }
+        case OP_BAND: { r.l = to_long(y) & to_long(x); return r; }
+        case OP_BOR: { r.l = to_long(y) | to_long(x); return r; }
+        case OP_BXOR: { r.l = to_long(y) ^ to_long(x); return r; }
+        case OP_MIN: return num_compare(y, x) < 0 ? y : x;
+        case OP_MAX: return num_compare(y, x) > 0 ? y : x;
+        default: return r;
+    }
+}
+
+/**
+ * @brief Tarefa que reduz um troço do array.
+ * 
+ * @param ctx Estado partilhado.
+ * @param i Índice do troço.
+ */
+void reduce_chunk(void *ctx, long i)
+{
+    REDUCAO *t = ctx;
+    long ini = i * t->tam + 1;
+    long fim = ini + t->tam - 1 < t->array->sp ? ini + t->tam - 1 : t->array->sp;
+    int inexato = 0;
+    DADOS acc = array_get(t->array, ini);
+    long j = ini + 1;
+
+    if (t->op == OP_ADD && t->array->formato == LONGS)
+    {
+        for (long soma; j <= fim && !__builtin_add_overflow(acc.l, t->array->longs[j], &soma); j++)
+            acc.l = soma;
+    }
+    else if (t->op == OP_ADD && t->array->formato == DOUBLES)
+    {
+        for (; j <= fim; j++)
+            acc.n += t->array->doubles[j];
+    }
+
+    for (; j <= fim; j++)       // Restantes operações, ou restantes elementos após o overflow de uma soma de inteiros
+        acc = fold_op(t->op, acc, array_get(t->array, j), &inexato);
+
+    t->parcial[i] = acc;
+    if (inexato)
+        t->inexato = 1;
+}
+
+/**
+ * @brief Reduz um intervalo por uma fórmula fechada: a soma de uma progressão aritmética (quando todas as somas parciais cabem num
+ * `long`, caso em que o resultado é igual ao da soma elemento a elemento) e o mínimo ou máximo, que é um dos extremos.
+ * 
+ * @param array Intervalo (não vazio).
+ * @param op Operação associativa.
+ * @param r Endereço onde é guardado o resultado.
+ * @return int Retorna 1 caso a redução tenha uma fórmula fechada, ou 0 caso contrário.
+ */
+int fold_range(STACK* array, OPCODE op, DADOS *r)
+{
+    long n = array->sp;
+    DADOS a = array_get(array, 1);
+    DADOS b = array_get(array, n);
+
+    switch (op)
+    {
+        case OP_ADD:
+        {
+            long limite;
+
+            if (a.l == LONG_MIN || b.l == LONG_MIN)
+                return 0;
+            if (__builtin_mul_overflow(2 * n, labs(a.l) > labs(b.l) ? labs(a.l) : labs(b.l), &limite))
+                return 0;           // Limite das somas parciais (e de cada parcela da fórmula)
+
+            r->tipo = LONG;
+            r->l = n * array->inicio + array->passo * (n % 2 == 0 ? n / 2 * (n - 1) : (n - 1) / 2 * n);
+            return 1;
+        }
+        case OP_MIN: { *r = array->passo >= 0 ? a : b; return 1; }
+        case OP_MAX: { *r = array->passo >= 0 ? b : a; return 1; }
+        default: return 0;
+    }
+}
+
+/**
+ * @brief Reduz um array de números com uma operação associativa através de um ciclo em C (`fold_op()`), sem executar o bloco. Os arrays
+ * grandes são repartidos em troços, reduzidos em paralelo, cujos resultados parciais são depois combinados pela ordem original.
+ * 
+ * A redução só é reagrupada quando o resultado é garantidamente igual ao da redução sequencial: com elementos DOUBLE, `+` e `*` só são
+ * reagrupados caso a variável de ambiente `OM_FLOAT_REASSOC` seja diferente de 0 (a soma de números de vírgula flutuante não é
+ * associativa). Caso contrário, a redução é feita num único troço. Caso algum resultado inteiro intermédio não caiba num `long`, a
+ * redução é abandonada e o bloco é executado normalmente (com resultados BIGINT), uma vez que as tarefas não alocam memória.
+ * 
+ * Os arrays compactos (ver `pack()`) não precisam de ser verificados e são somados com um ciclo direto sobre os seus valores. Os
+ * intervalos são reduzidos, sempre que possível, por uma fórmula fechada (`fold_range()`).
+ * 
+ * @param s Stack.
+ * @param array Array.
+ * @param op Operação associativa.
+ * @return int Retorna 1 caso a redução tenha sido feita, ou 0 caso o array não seja apenas de números LONG e DOUBLE ou algum resultado
+ * exceda um `long` (e o bloco tenha de ser executado).
+ */
+int fold_kernel(STACK* s, STACK* array, OPCODE op)
+{
+    int reais = 0;
+
+    if (array->sp == 0)
+        return 0;
+    if (array->formato == GENERICO)
+    {
+        for (int i = 1; i <= array->sp; i++)
+        {
+            TIPO tipo = array->stack[i].tipo;
+            if (tipo != LONG && tipo != DOUBLE)
+                return 0;
+            reais |= tipo == DOUBLE;
+        }
+    }
+    else
+        reais = array->formato == DOUBLES;
+
+    DADOS acc;
+    if (array->formato == INTERVALO && fold_range(array, op, &acc))
+    {
+        STACK *r = new_stack_cap(1);
+        push(r, acc);
+        push_array(s, r);
+        return 1;
+    }
+
+    long k = 1;
+    if (array->sp >= parallel_threshold() && num_threads() > 1)
+        if (!reais || (op != OP_ADD && op != OP_MUL) || env_long("OM_FLOAT_REASSOC", 0) != 0)
+            k = num_threads() * 4L;
+
+    REDUCAO t = { array, op, (array->sp + k - 1) / k, NULL, 0 };
+    k = (array->sp + t.tam - 1) / t.tam;
+    t.parcial = malloc(sizeof(DADOS) * k);
+
+    parallel_for(k, reduce_chunk, &t);
+
+    acc = t.parcial[0];
+    for (long i = 1; i < k; i++)
+        acc = fold_op(op, acc, t.parcial[i], &t.inexato);
+
+    free(t.parcial);
+    if (t.inexato)
+        return 0;
+
+    STACK *r = new_stack_cap(1);
+    push(r, acc);
+    push_array(s, r);
+    return 1;
+}
+
 /**
  * @brief Aplica as operações contidas num bloco iterativamente aos elementos de um array. Por exemplo, o input: `[ 1 2 3 ] { + } *` daria o output: `6`
  * (soma de todos os elemetnos do array). 
  * 
+ * Os arrays de números são reduzidos diretamente (e, quando são grandes, em paralelo) com `fold_kernel()`, caso o bloco seja associativo.
+ * A redução de um array vazio é um array vazio.
+ * 
  * @param s Stack.
  * @param b Bloco.
  * @param a Array.
@@ -212,55 +710,52 @@ void filter_string(STACK* s, DADOS block, DADOS string, DADOS *var)
  */
 void fold_array(STACK* s, DADOS b, DADOS a, DADOS *var)
 {
-    char *block = b.dados;
-    if (strlen(block) == 1)
+    OPCODE op = associative_op(block_program(b));
+
+    if (a.tipo == ARRAY)
+        a.dados = linearize(a.dados);
+
+    if (op != OP_NOP && a.tipo == ARRAY && fold_kernel(s, a.dados, op))
+        return;
+    if (a.tipo == ARRAY && ((STACK*)a.dados)->sp == 0)
+    {
+        push_array(s, new_stack());
+        return;
+    }
+
+    if (((BLOCO*)b.dados)->len == 1)
     {
         STACK *array = a.dados;
         STACK *stack = new_stack();
         STACK *r = new_stack();
 
-        char token[BUFSIZ];
-        char* line = malloc(sizeof(char) * BUFSIZ);
-        line = b.dados;
+        PROGRAMA* p = block_program(b);
 
-        push(stack, array->stack[1]);
+        push(stack, array_get(array, 1));
         for(int i = 2; i <= array->sp; i++)
         {
-            push(stack, array->stack[i]);
-            while ((line = get_token(line, token)) && *line != '\0'){
-                handle_token(stack, token, var);
-            }
-            handle_token(stack, token, var);
-
-            line = b.dados;
+            push(stack, array_get(array, i));
+            run_program(stack, p, var);
         }
         
         push(r, pop(stack));
-        push_array(s, *r);
+        push_array(s, r);
     }
     else
     {
         STACK *array = a.dados;
         
-        STACK *r = new_stack();
-        r->cap = array->cap;
-        r->stack = malloc(sizeof(DADOS) * array->cap);    
+        STACK *r = new_stack_cap(array->sp);
         
-        char token[BUFSIZ];
-        char* line = malloc(sizeof(char) * BUFSIZ);
-        line = b.dados;
+        PROGRAMA* p = block_program(b);
 
-        push(r, array->stack[1]);
+        push(r, array_get(array, 1));
         for(int i = 2; i <= array->sp; ++i)
         {
-            push(r, array->stack[i]);
-            while ((line = get_token(line, token)) && *line != '\0'){
-                handle_token(r, token, var);
-            }
-            handle_token(r, token, var);
-            line = b.dados;
+            push(r, array_get(array, i));
+            run_program(r, p, var);
         }
-        push_array(s, *r);
+        push_array(s, r);
     }
 }
 
@@ -276,8 +771,8 @@ int is_truthy (STACK* s)
 
     if (x.tipo == STRING)
     {
-        char *str = x.dados;
-        if (strlen(str) == 0) return 0;
+        STR *str = x.dados;
+        if (str->len == 0) return 0;
         else return 1;
     }
     else if (x.tipo == ARRAY)
@@ -288,11 +783,11 @@ int is_truthy (STACK* s)
     }
     else if (x.tipo == LONG || x.tipo == DOUBLE)
     {
-        double *n = x.dados;
-        double p = *n;
-        if (p == 0) return 0;
+        if (to_double(x) == 0) return 0;
         else return 1;
     }
+    else if (x.tipo == BIGINT)
+        return 1;
 
     return 0;
 }
@@ -312,107 +807,312 @@ void truthy (STACK* s, DADOS *var)
         execute_block(s,x,var);
 }
 
+#define SORT_INSERCAO 16 ///< Tamanho dos troços que são ordenados por inserção antes de serem intercalados.
+#define SORT_PARALELO 65536 ///< Número de elementos a partir do qual a ordenação é repartida pelas threads disponíveis.
+
 /**
- * @brief Função auxiliar para mecanismos de ordenação.
- *        
- * @param s Stack.
- * @param i Posição de elemento na stack.
+ * @brief Elemento a ordenar, acompanhado da chave calculada pelo bloco de ordenação.
  */
+typedef struct
+{
+    DADOS chave; ///< Chave de ordenação.
+    DADOS valor; ///< Elemento original.
+} PAR;
 
-void swap_sort(STACK* s, int i)
+/**
+ * @brief Estado partilhado pelas tarefas de uma ordenação repartida por várias threads.
+ * 
+ * - `de`: __Array com os troços a intercalar.__
+ * - `para`: __Array onde é escrito o resultado da intercalação.__
+ * - `n`: __Número de elementos.__
+ * - `tam`: __Tamanho de cada troço já ordenado.__
+ * - `partes`: __Número de tarefas em que é repartida a intercalação de cada par de troços.__
+ */
+typedef struct
 {
-    DADOS t = s->stack[i];
+    PAR *de; ///< Origem.
+    PAR *para; ///< Destino.
+    long n; ///< Número de elementos.
+    long tam; ///< Tamanho dos troços.
+    long partes; ///< Tarefas por par de troços.
+} ORDENACAO;
 
-    s->stack[i] = s->stack[i+1]; 
-    s->stack[i+1] = t;
+/**
+ * @brief Ordena um troço pequeno por inserção (de forma estável).
+ * 
+ * @param v Elementos.
+ * @param n Número de elementos.
+ */
+void insertion_sort(PAR *v, long n)
+{
+    for (long i = 1; i < n; i++)
+    {
+        PAR p = v[i];
+        long j;
+
+        for (j = i; j > 0 && compare(v[j-1].chave, p.chave) > 0; j--)
+            v[j] = v[j-1];
+        v[j] = p;
+    }
 }
 
 /**
- * @brief Função auxiliar para mecanismos de ordenação (sort).
- *        
- * @param target Stack.
- * @param tool Stack auxiliar.
- * @param N nº elementos da stack auxiliar.
+ * @brief Intercala dois troços ordenados. Em caso de empate, os elementos de __a__ ficam primeiro, o que torna a ordenação estável.
+ * 
+ * @param a Primeiro troço.
+ * @param na Número de elementos do primeiro troço.
+ * @param b Segundo troço.
+ * @param nb Número de elementos do segundo troço.
+ * @param r Destino, com espaço para `na + nb` elementos.
  */
+void merge(PAR *a, long na, PAR *b, long nb, PAR *r)
+{
+    long i = 0, j = 0, k = 0;
+
+    while (i < na && j < nb)
+        r[k++] = compare(b[j].chave, a[i].chave) < 0 ? b[j++] : a[i++];
+    while (i < na)
+        r[k++] = a[i++];
+    while (j < nb)
+        r[k++] = b[j++];
+}
 
-void bubble_sort(STACK* target, STACK* tool, int N)
+/**
+ * @brief Calcula quantos dos primeiros __k__ elementos da intercalação de __a__ com __b__ vêm de __a__, por pesquisa binária.
+ * 
+ * Permite que a intercalação de dois troços seja repartida em partes independentes.
+ * 
+ * @param k Número de elementos da intercalação.
+ * @param a Primeiro troço.
+ * @param na Número de elementos do primeiro troço.
+ * @param b Segundo troço.
+ * @param nb Número de elementos do segundo troço.
+ * @return long Retorna o número de elementos de __a__.
+ */
+long co_rank(long k, PAR *a, long na, PAR *b, long nb)
 {
-    double a, b;
+    long lo = k > nb ? k - nb : 0;
+    long hi = k < na ? k : na;
 
-    int i, j;
-    for (i = 1; i <= N; ++i)
+    while (lo < hi)
     {
-        for (j = 1; j <= N - i; ++j)
-        {
-            a = *(double*)(tool->stack[j].dados);
-            b = *(double*)(tool->stack[j+1].dados);
-            if (a > b)
-            {
-                swap_sort(target, j);
-                swap_sort(tool, j);
-            }
-        }
+        long i = lo + (hi - lo) / 2;
+        long j = k - i;
+
+        if (j == 0 || compare(b[j-1].chave, a[i].chave) < 0)
+            hi = i;
+        else
+            lo = i + 1;
     }
+
+    return lo;
 }
 
 /**
- * @brief Função auxiliar que copia uma stack para uma nova stack.
+ * @brief Ordena os elementos de forma estável (merge sort: troços pequenos ordenados por inserção e intercalados dois a dois).
  * 
- * @param original Stack original.
- * @param new_array Nova stack.
- * @return STACK* Devolve o endereço da nova stack.
+ * @param v Elementos (onde fica o resultado).
+ * @param aux Array auxiliar com espaço para __n__ elementos.
+ * @param n Número de elementos.
  */
-STACK* copy_stack(STACK* original, STACK* new_array)
+void merge_sort(PAR *v, PAR *aux, long n)
 {
-    for (int i = 1; i <= original->sp; ++i)
+    PAR *de = v, *para = aux, *t;
+
+    for (long i = 0; i < n; i += SORT_INSERCAO)
+        insertion_sort(v + i, n - i < SORT_INSERCAO ? n - i : SORT_INSERCAO);
+
+    for (long w = SORT_INSERCAO; w < n; w *= 2)
     {
-        if (original->stack[i].tipo == ARRAY)
+        for (long i = 0; i < n; i += 2 * w)
         {
-            STACK* array = new_stack();
-            array = copy_stack(original->stack[i].dados, array);
+            long na = n - i < w ? n - i : w;
+            long nb = n - i - na < w ? n - i - na : w;
 
-            new_array->stack = memory_checker(new_array);
-            push_array(new_array, *array);
-        }
-        else
-        {
-            new_array->stack = memory_checker(new_array);
-            push(new_array, original->stack[i]); 
-        
+            merge(de + i, na, de + i + na, nb, para + i);
         }
+
+        t = de; de = para; para = t;
     }
-    return new_array;
+
+    if (de != v)
+        memcpy(v, de, sizeof(PAR) * n);
+}
+
+/**
+ * @brief Tarefa que ordena o troço __i__ de uma ordenação paralela.
+ * 
+ * @param ctx Endereço do estado da ordenação.
+ * @param i Índice do troço.
+ */
+void sort_chunk(void *ctx, long i)
+{
+    ORDENACAO *o = ctx;
+    long ini = i * o->tam;
+    long n = o->n - ini < o->tam ? o->n - ini : o->tam;
+
+    merge_sort(o->de + ini, o->para + ini, n);
 }
 
 /**
- * @brief Ordena um array de acordo com as condições definidas num bloco.
+ * @brief Tarefa que intercala uma parte de um par de troços de uma ordenação paralela.
+ * 
+ * @param ctx Endereço do estado da ordenação.
+ * @param i Índice da tarefa (par de troços e parte deste).
+ */
+void merge_chunk(void *ctx, long i)
+{
+    ORDENACAO *o = ctx;
+    long ini = (i / o->partes) * 2 * o->tam;
+    long parte = i % o->partes;
+
+    long na = o->n - ini < o->tam ? o->n - ini : o->tam;
+    long nb = o->n - ini - na < o->tam ? o->n - ini - na : o->tam;
+    PAR *a = o->de + ini, *b = a + na;
+
+    long k0 = (na + nb) * parte / o->partes;
+    long k1 = (na + nb) * (parte + 1) / o->partes;
+    long i0 = co_rank(k0, a, na, b, nb);
+    long i1 = co_rank(k1, a, na, b, nb);
+
+    merge(a + i0, i1 - i0, b + k0 - i0, (k1 - i1) - (k0 - i0), o->para + ini + k0);
+}
+
+/**
+ * @brief Ordena os elementos de forma estável, repartindo o trabalho pelas threads disponíveis.
+ * 
+ * Cada thread ordena um troço com `merge_sort()`; os troços são depois intercalados dois a dois, sendo cada intercalação repartida em
+ * partes independentes (com `co_rank()`) para que todas as threads participem até à última intercalação.
+ * 
+ * @param v Elementos (onde fica o resultado).
+ * @param aux Array auxiliar com espaço para __n__ elementos.
+ * @param n Número de elementos.
+ */
+void parallel_sort(PAR *v, PAR *aux, long n)
+{
+    long nt = num_threads();
+    ORDENACAO o = { v, aux, n, (n + nt - 1) / nt, 1 };
+    PAR *t;
+
+    parallel_for(nt, sort_chunk, &o);
+
+    for (; o.tam < n; o.tam *= 2)
+    {
+        long pares = (n + 2 * o.tam - 1) / (2 * o.tam);
+
+        o.partes = (nt + pares - 1) / pares;
+        parallel_for(pares * o.partes, merge_chunk, &o);
+
+        t = o.de; o.de = o.para; o.para = t;
+    }
+
+    if (o.de != v)
+        memcpy(v, o.de, sizeof(PAR) * n);
+}
+
+/**
+ * @brief Compara dois `long`, para a ordenação com `qsort()` de um array compacto.
+ * 
+ * @param a Endereço do primeiro valor.
+ * @param b Endereço do segundo valor.
+ * @return int Retorna um valor negativo, zero ou positivo, caso o primeiro valor seja menor, igual ou maior que o segundo.
+ */
+int compare_longs(const void *a, const void *b)
+{
+    long x = *(const long*)a;
+    long y = *(const long*)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Ordena um array (ou os caracteres de uma string) de acordo com as chaves calculadas por um bloco.
+ * 
+ * O bloco é executado uma única vez por elemento e os elementos são ordenados, de forma estável, pelas chaves obtidas (comparadas com
+ * `compare()`). Os arrays grandes são ordenados em várias threads.
+ * 
+ * - __Nota:__ Caso o bloco não deixe nenhum valor na stack (por exemplo `{ }`), a chave é o próprio elemento. Um array `LONGS` ordenado
+ * por `{ }` é ordenado diretamente sobre os seus valores (os valores iguais são indistinguíveis, pelo que a estabilidade não importa) e um
+ * intervalo ordenado por `{ }` é o próprio intervalo ou o intervalo inverso.
  * 
  * @param s Stack.
- * @param array Array.
+ * @param array Array ou string.
  * @param block Bloco.
  * @param var Array de variáveis (para handling dos inputs do bloco).
  */
 void sort(STACK* s, DADOS array, DADOS block, DADOS *var)
 {
-    STACK* target = new_stack();
-    target = copy_stack(array.dados, target);
-    
-    if (array.tipo == STRING)
+    STR* str = array.tipo == STRING ? array.dados : NULL;
+    STACK* a = array.tipo == ARRAY ? linearize(array.dados) : NULL;
+    long i, n = str ? str->len : a ? a->sp : 0;
+
+    if (a && a->formato == INTERVALO && block_program(block)->n == 0)
     {
-        STACK* new_array = new_stack();
-        char* str = array.dados;
-        for (int i = 1; *(str+i); ++i)
-            push_char(new_array, *(str+i));
+        long ultimo = a->inicio + (n - 1) * a->passo;
 
-        array.dados = new_array;
+        push_array(s, a->passo >= 0 ? array_slice(a, 1, n) : new_range(ultimo, -a->passo, n));
+        return;
     }
-   
-    push_array(s, *(STACK*)array.dados);
-    push_block(s, block.dados);
-    mod(s, var);
+    if (a && a->formato == LONGS && block_program(block)->n == 0)
+    {
+        STACK* r = array_slice(a, 1, n);
 
-    STACK* tool = pop(s).dados;
-    bubble_sort(target, tool, tool->sp);
+        unshare(r);
+        qsort(r->longs + 1, n, sizeof(long), compare_longs);
+        push_array(s, r);
+        return;
+    }
+
+    PAR* v = malloc(sizeof(PAR) * (n + 1));
+    STACK* stack = new_stack();
+    PROGRAMA* p = block_program(block);
+    KERNEL kernel;
+    KERNEL* k = block_kernel(p, &kernel) ? &kernel : NULL;
+
+    for (i = 0; i < n; i++)
+    {
+        DADOS e;
+        if (str)
+        {
+            e.tipo = CHAR;
+            e.c = str->str[i];
+        }
+        else
+            e = array_get(a, i + 1);
+
+        stack->sp = 0;
+        apply_block(stack, e, p, k, var);
+
+        v[i].chave = stack->sp > 0 ? stack->stack[stack->sp] : e;
+        v[i].valor = e;
+    }
+
+    PAR* aux = malloc(sizeof(PAR) * (n + 1));
+    if (n >= SORT_PARALELO && num_threads() > 1)
+        parallel_sort(v, aux, n);
+    else
+        merge_sort(v, aux, n);
+    free(aux);
+
+    if (str)
+    {
+        STR* r = new_str_cap(n);
+        for (i = 0; i < n; i++)
+            r->str[i] = v[i].valor.c;
+        r->str[n] = '\0';
+        r->len = n;
+
+        push_string(s, r);
+    }
+    else
+    {
+        STACK* r = new_array(result_format(a), n);
+        for (i = 0; i < n; i++)
+            array_set(r, i + 1, v[i].valor);
+        r->sp = n;
+
+        push_array(s, r);
+    }
 
-    push_array(s, *target);
+    free(v);
 }
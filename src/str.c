@@ -0,0 +1,331 @@
+/**
+ * @file str.c
+ * @brief Representação das strings: comprimento e capacidade guardados junto dos caracteres e contagem de referências.
+ *
+ * Uma STRING aponta para uma estrutura STR, que é partilhada por todas as cópias da string (por exemplo, após `_` ou ao ler uma
+ * variável). Como o comprimento é guardado, nenhuma operação precisa de voltar a percorrer a string com `strlen()`. Uma string só é
+ * alterada no próprio lugar quando tem uma única referência; caso contrário é copiada antes de ser alterada (*copy-on-write*).
+ *
+ * As partes de uma string partilhada (`(`, `)`, `<` e `>`) são vistas sobre os caracteres da string original, pelo que não são copiadas.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stack.h"
+
+/**
+ * @brief Cria uma nova string vazia, com capacidade para __cap__ caracteres.
+ *
+ * @param cap Capacidade.
+ * @return STR* Retorna o endereço da nova string, com uma referência.
+ */
+STR* new_str_cap(long cap)
+{
+    STR *r = arena_alloc(sizeof(STR));
+
+    r->str = arena_alloc(cap + 1);
+    r->str[0] = '\0';
+    r->len = 0;
+    r->cap = cap;
+    r->refs = 1;
+    r->base = NULL;
+    r->usado = 0;
+
+    return r;
+}
+
+/**
+ * @brief Verifica o comprimento de uma string que ainda vai ser construída. Um comprimento maior do que `STR_MAX` termina o programa com
+ * uma mensagem de erro, tal como `check_length()` faz para os arrays.
+ *
+ * @param n Comprimento.
+ * @return long Retorna o comprimento.
+ */
+long check_str_length(long n)
+{
+    if (n > STR_MAX)
+    {
+        fprintf(stderr, "Erro: string com %ld caracteres (máximo %d)\n", n, STR_MAX);
+        exit(EXIT_FAILURE);
+    }
+
+    return n;
+}
+
+/**
+ * @brief Cria uma nova string com uma cópia dos __len__ caracteres de __s__.
+ *
+ * @param s Caracteres.
+ * @param len Número de caracteres.
+ * @return STR* Retorna o endereço da nova string, com uma referência.
+ */
+STR* new_str(const char *s, long len)
+{
+    STR *r = new_str_cap(len);
+
+    memcpy(r->str, s, len);
+    r->str[len] = '\0';
+    r->len = len;
+
+    return r;
+}
+
+/**
+ * @brief Garante que a string de um elemento pode ser alterada, copiando-a caso esta seja partilhada por outros elementos.
+ *
+ * @param d Endereço do elemento do tipo STRING (cujo endereço dos dados pode ser alterado).
+ * @return STR* Retorna a string que pode ser alterada no próprio lugar.
+ */
+STR* str_unique(DADOS *d)
+{
+    STR *a = d->dados;
+
+    if (a->refs <= 1 && a->base == NULL)
+        return a;
+
+    STR *r = new_str(a->str, a->len);
+    str_release(a);
+    d->dados = r;
+
+    return r;
+}
+
+/**
+ * @brief Reduz uma string aos __n__ caracteres a partir da posição __ini__ (por exemplo, em `(`, `)`, `<` e `>`), sem copiar caracteres.
+ * 
+ * Uma string que não é partilhada é alterada no próprio lugar; caso contrário é criada uma vista que partilha os caracteres da string
+ * original (a referência do elemento passa para a vista).
+ * 
+ * @param d Endereço do elemento do tipo STRING (cujo endereço dos dados pode ser alterado).
+ * @param ini Posição do primeiro caracter.
+ * @param n Número de caracteres.
+ * @return STR* Retorna a string reduzida.
+ */
+STR* str_slice(DADOS *d, long ini, long n)
+{
+    STR *a = d->dados;
+
+    if (a->refs <= 1 && a->base == NULL)
+    {
+        a->str += ini;
+        a->cap -= ini;
+        a->len = n;
+        a->usado = n;
+        a->str[n] = '\0';
+        return a;
+    }
+
+    STR *base = a->base != NULL ? a->base : a;
+    STR *r = arena_alloc(sizeof(STR));
+
+    r->str = a->str + ini;
+    r->len = n;
+    r->cap = n;
+    r->refs = 1;
+    r->base = base;
+    r->usado = n;
+
+    if (base->refs != STR_FIXA)
+        base->refs++;
+    str_release(a);
+    d->dados = r;
+
+    return r;
+}
+
+/**
+ * @brief Regista que uma referência para uma string deixou de existir. Quando uma vista deixa de ter referências, deixa também de
+ * referenciar a sua base.
+ * 
+ * @param a String.
+ */
+void str_release(STR *a)
+{
+    if (a->refs == STR_FIXA)
+        return;
+    if (--a->refs == 0 && a->base != NULL)
+        str_release(a->base);
+}
+
+/**
+ * @brief Devolve os caracteres de uma string terminados em '\0', para as funções da biblioteca de C que o exigem (copiando-os, caso a
+ * string seja uma vista que não termina no fim da sua base).
+ * 
+ * @param a String.
+ * @return const char* Retorna os caracteres terminados em '\0'.
+ */
+const char* str_cstr(STR *a)
+{
+    if (a->str[a->len] == '\0')
+        return a->str;
+
+    return new_str(a->str, a->len)->str;
+}
+
+/**
+ * @brief Acrescenta __n__ caracteres ao fim de uma string que não é partilhada, duplicando a sua capacidade quando necessário.
+ *
+ * @param a String (com uma única referência).
+ * @param b Caracteres a acrescentar.
+ * @param n Número de caracteres.
+ */
+void str_append(STR *a, const char *b, long n)
+{
+    if (a->len + n > a->cap)
+    {
+        long cap = a->cap * 2;
+        if (cap < a->len + n)
+            cap = a->len + n;
+
+        a->str = arena_realloc(a->str, a->cap + 1, cap + 1);
+        a->cap = cap;
+    }
+
+    memmove(a->str + a->len, b, n);
+    a->len += n;
+    a->usado = a->len;
+    a->str[a->len] = '\0';
+}
+
+/**
+ * @brief Acrescenta __n__ caracteres ao fim da string de um elemento (por exemplo, em `+`), sem copiar a string sempre que possível.
+ * 
+ * Uma string que não é partilhada é alterada no próprio lugar. Uma string partilhada que termina no fim dos caracteres ocupados da sua
+ * base (`usado`) e cuja base tem capacidade para os novos caracteres é prolongada por uma vista, que escreve no espaço livre da base (a
+ * string original mantém o seu comprimento, pelo que não é alterada). Caso contrário, a string é copiada com o dobro da capacidade
+ * necessária. Desta forma, concatenar repetidamente ao fim de uma string tem custo linear, mesmo que esta esteja guardada numa variável.
+ * 
+ * @param d Endereço do elemento do tipo STRING (cujo endereço dos dados pode ser alterado).
+ * @param b Caracteres a acrescentar (que podem ser da própria string).
+ * @param n Número de caracteres.
+ * @return STR* Retorna a string resultante.
+ */
+STR* str_concat(DADOS *d, const char *b, long n)
+{
+    STR *a = d->dados;
+    STR *base = a->base != NULL ? a->base : a;
+    long usado = base->usado > base->len ? base->usado : base->len;
+    STR *r;
+
+    if (a->refs <= 1 && a->base == NULL)
+    {
+        str_append(a, b, n);
+        return a;
+    }
+
+    if (base->refs != STR_FIXA && a->str + a->len == base->str + usado && usado + n <= base->cap)
+    {
+        memmove(base->str + usado, b, n);
+        base->usado = usado + n;
+        base->str[base->usado] = '\0';
+
+        r = arena_alloc(sizeof(STR));
+        r->str = a->str;
+        r->len = a->len + n;
+        r->cap = r->len;
+        r->refs = 1;
+        r->base = base;
+        r->usado = r->len;
+        base->refs++;
+    }
+    else
+    {
+        r = new_str_cap(2 * (a->len + n));
+        str_append(r, a->str, a->len);
+        str_append(r, b, n);
+    }
+
+    str_release(a);
+    d->dados = r;
+    return r;
+}
+
+/**
+ * @brief Procura a primeira ocorrência de __n__ caracteres de __b__ numa string, a partir da posição __from__.
+ *
+ * @param a String onde é feita a procura.
+ * @param b Caracteres a procurar.
+ * @param n Número de caracteres a procurar.
+ * @param from Posição a partir da qual é feita a procura.
+ * @return long Retorna a posição da ocorrência, ou -1 caso esta não exista.
+ */
+long str_find(STR *a, const char *b, long n, long from)
+{
+    if (n == 0)
+        return from <= a->len ? from : -1;
+
+    const char *p = a->str + from;
+    const char *fim = a->str + a->len - n;
+
+    while (p <= fim)
+    {
+        p = memchr(p, b[0], fim - p + 1);
+        if (p == NULL)
+            return -1;
+        if (memcmp(p, b, n) == 0)
+            return p - a->str;
+        p++;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Compara duas strings lexicograficamente (byte a byte e, em caso de empate, pelo comprimento).
+ *
+ * @param a String.
+ * @param b String.
+ * @return int Retorna um valor negativo, zero ou positivo, caso __a__ seja menor, igual ou maior que __b__.
+ */
+int str_compare(STR *a, STR *b)
+{
+    long n = a->len < b->len ? a->len : b->len;
+    int r = memcmp(a->str, b->str, n);
+
+    if (r != 0)
+        return r;
+
+    return (a->len > b->len) - (a->len < b->len);
+}
+
+/**
+ * @brief Fixa a contagem de referências de todas as strings de um valor (percorrendo os arrays recursivamente) em `STR_FIXA`, para que
+ * estas possam ser partilhadas por várias threads sem que nenhuma as altere ou atualize a sua contagem.
+ *
+ * @param d Valor.
+ * @return int Retorna 0 caso o valor contenha algum bloco (cuja execução não pode ser feita em paralelo), ou 1 caso contrário.
+ */
+int freeze(DADOS d)
+{
+    if (d.tipo == STRING)
+    {
+        STR *a = d.dados;
+
+        a->refs = STR_FIXA;
+        if (a->base != NULL)
+            a->base->refs = STR_FIXA;
+    }
+    else if (d.tipo == ARRAY)
+    {
+        STACK *a = d.dados;
+
+        if (a->formato == ARVORE)
+        {
+            d.dados = a->esq;
+            if (!freeze(d))
+                return 0;
+            d.dados = a->dir;
+            return freeze(d);
+        }
+        if (a->formato != GENERICO)
+            return 1;
+        for (int i = 1; i <= a->sp; i++)
+            if (!freeze(a->stack[i]))
+                return 0;
+    }
+    else if (d.tipo == BLOCK)
+        return 0;
+
+    return 1;
+}
@@ -0,0 +1,66 @@
+#!/bin/sh
+# Testes de regressão do interpretador.
+#
+# Cada linha de um ficheiro tests/*.in é um programa; um `\n` separa o programa das linhas de input lidas por `l` e `t`. O output de cada
+# programa (e a mensagem de erro e o código de saída, caso termine com erro) é comparado com o ficheiro .out correspondente, primeiro em
+# série (OM_THREADS=1) e depois com todas as operações sobre arrays feitas em paralelo (OM_THREADS=4, OM_PARALELO_MIN=1), pelo que os
+# dois caminhos têm de dar exatamente o mesmo resultado.
+#
+# Uso (a partir de src/): sh tests/run.sh [-u]
+#   -u  regrava os ficheiros .out com o output atual (em série); as diferenças devem ser revistas antes de serem guardadas.
+
+cd "$(dirname "$0")" || exit 1
+
+MAIN=../main
+falhas=0
+
+# Executa os programas de um ficheiro, um de cada vez, escrevendo cada programa seguido do seu output.
+executa()
+{
+    while IFS= read -r programa
+    do
+        printf '$ %s\n' "$programa"
+        printf '%b\n' "$programa" | "$MAIN" 2>&1
+        estado=$?
+        [ "$estado" -ne 0 ] && printf '[saída %d]\n' "$estado"
+    done < "$1"
+}
+
+# Compara o output de um ficheiro com o esperado, no modo dado pelas variáveis de ambiente já exportadas.
+verifica()
+{
+    if ! executa "$1" | diff -u "${1%.in}.out" - > diferencas.tmp
+    then
+        echo "FALHOU: $1 ($2)"
+        cat diferencas.tmp
+        falhas=$((falhas + 1))
+    fi
+    rm -f diferencas.tmp
+}
+
+for entrada in *.in
+do
+    export OM_THREADS=1
+    unset OM_PARALELO_MIN
+
+    if [ "$1" = "-u" ]
+    then
+        executa "$entrada" > "${entrada%.in}.out"
+        continue
+    fi
+
+    verifica "$entrada" "em série"
+
+    export OM_THREADS=4 OM_PARALELO_MIN=1
+    verifica "$entrada" "em paralelo"
+done
+
+[ "$1" = "-u" ] && exit 0
+
+if [ "$falhas" -eq 0 ]
+then
+    echo "Todos os testes passaram."
+else
+    echo "$falhas teste(s) falharam."
+    exit 1
+fi